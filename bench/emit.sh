@@ -0,0 +1,17 @@
+#!/bin/sh
+# Writes the generated program of `veritas bench parse` once as textual IR and once as bitcode,
+# then prints the emit phase of --time-report and the size of each output.
+# Usage: bench/emit.sh [veritas binary] [functions]
+set -e
+VERITAS=${1:-veritas}
+SIZE=${2:-20000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+"$VERITAS" bench parse --bench-size="$SIZE" -o "$DIR/big.vrs"
+echo "input: $(wc -c < "$DIR/big.vrs") bytes, $SIZE functions"
+echo "kind  phase           wall (ms)     cpu (ms)  peak RSS (MB)       allocs  output (bytes)"
+for kind in llvm bc; do
+	"$VERITAS" "$DIR/big.vrs" --emit=$kind -o "$DIR/big.$kind" --time-report 2> "$DIR/report.txt"
+	printf '%-5s %s  %s\n' "$kind" "$(grep '^emit ' "$DIR/report.txt")" "$(wc -c < "$DIR/big.$kind")"
+done
@@ -0,0 +1,21 @@
+#!/bin/sh
+# Compiles each kernel at -O2 and reports the vector instructions of the kernel function and whether
+# LoopVectorize produced a vector.body loop in it, then runs it with --time-report.
+# Usage: bench/kernels.sh [veritas binary] [extra options, e.g. -mcpu=native]
+set -e
+VERITAS=${1:-veritas}
+[ $# -gt 0 ] && shift
+BENCH=$(dirname "$0")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+for kernel in saxpy dot dot8; do
+	"$VERITAS" "$BENCH/$kernel.vrs" -O2 "$@" --emit=llvm -o "$DIR/$kernel.ll"
+	# The body of the kernel function, it is noinline so it stays on its own
+	awk "/^define .*@$kernel\\(/,/^}/" "$DIR/$kernel.ll" > "$DIR/body.ll"
+	vectors=$(grep -o '<[0-9]* x float>' "$DIR/body.ll" | sort -u | tr '\n' ' ')
+	if grep -q '^vector.body:' "$DIR/body.ll"; then loop=yes; else loop=no; fi
+	echo "$kernel: LoopVectorize: $loop, vector types: ${vectors:-none}"
+	"$VERITAS" run "$BENCH/$kernel.vrs" -O2 "$@" --time-report 2> "$DIR/report.txt"
+	grep -E '^(optimize|jit|run) ' "$DIR/report.txt"
+done
@@ -0,0 +1,56 @@
+#include "headers/Arena.h"
+
+Arena::Arena(size_t blockSize)
+	: m_blockSize(blockSize)
+{
+}
+
+void* Arena::Allocate(size_t size, size_t align)
+{
+	uintptr_t current = reinterpret_cast<uintptr_t>(m_cursor);
+	uintptr_t aligned = (current + align - 1) & ~(uintptr_t)(align - 1);
+
+	if (m_cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(m_blockEnd))
+	{
+		NewBlock(size + align);
+		current = reinterpret_cast<uintptr_t>(m_cursor);
+		aligned = (current + align - 1) & ~(uintptr_t)(align - 1);
+	}
+
+	m_cursor = reinterpret_cast<char*>(aligned + size);
+	m_bytesUsed += size;
+	return reinterpret_cast<void*>(aligned);
+}
+
+std::string_view Arena::CopyString(std::string_view str)
+{
+	if (str.empty())
+		return {};
+
+	char* dst = static_cast<char*>(Allocate(str.size(), 1));
+	std::memcpy(dst, str.data(), str.size());
+	return std::string_view(dst, str.size());
+}
+
+size_t Arena::getBytesUsed() const
+{
+	return m_bytesUsed;
+}
+
+size_t Arena::getBlockCount() const
+{
+	return m_blocks.size();
+}
+
+size_t Arena::getObjectCount() const
+{
+	return m_objectCount;
+}
+
+void Arena::NewBlock(size_t minSize)
+{
+	size_t size = minSize > m_blockSize ? minSize : m_blockSize;
+	m_blocks.emplace_back(new char[size]);
+	m_cursor = m_blocks.back().get();
+	m_blockEnd = m_cursor + size;
+}
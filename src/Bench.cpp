@@ -0,0 +1,383 @@
+#include "headers/Bench.h"
+#include "headers/Keywords.h"
+#include "headers/Logger.h"
+#include "headers/Parser.h"
+#include "headers/SourceFile.h"
+#include "headers/Tokenizer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	// A fixed LCG, so a size gives the same program on every platform, which the std distributions do not
+	class Random
+	{
+	public:
+		explicit Random(uint64_t seed) : m_state(seed) {}
+
+		unsigned Next(unsigned bound)
+		{
+			m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+			return static_cast<unsigned>((m_state >> 33) % bound);
+		}
+
+	private:
+		uint64_t m_state;
+	};
+
+	struct BenchInput
+	{
+		std::string name;
+		std::string text;
+	};
+
+	// Best of the runs, in seconds
+	struct FrontEndTimes
+	{
+		size_t tokens = 0;
+		double tokenize = 0.0;
+		double parse = 0.0;
+	};
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Declarations, calls, loops and arithmetic the way hand written code mixes them. Every function calls
+// the one before it except every 16th, so the program also compiles and runs, see bench/README.md
+static std::string GenerateDeclarations(unsigned functions)
+{
+	static const char* const types[] = { "i32", "i64", "f64" };
+	Random random(1);
+	std::string text = "fn extern printf(fmt: i8*, ...) -> i32;\n\n";
+	char line[256];
+
+	for (unsigned i = 0; i < functions; i++)
+	{
+		std::snprintf(line, sizeof(line), "// function number %u\nfn func%u(a: i32, b: i64) -> i64\n{\n", i, i);
+		text += line;
+		for (unsigned j = 0; j < 8; j++)
+		{
+			// Each value reads the parameters and the one declared before it, kept small enough to convert between the types
+			std::string previous = j == 0 ? "a" : "v" + std::to_string(j - 1);
+			std::snprintf(line, sizeof(line), "\tlet v%u: %s = (%s %% 1000 * %u + b) - %u / (a %% 7 + 1);\n", j, types[random.Next(3)],
+				previous.c_str(), random.Next(100) + 1, random.Next(1000));
+			text += line;
+		}
+		std::snprintf(line, sizeof(line), "\tlet xs: [i64; 16];\n\tfor k in 0..len(xs)\n\t{\n\t\txs[k] = k * %u + v7;\n\t}\n", random.Next(10) + 1);
+		text += line;
+		if (i % 16 != 0)
+			std::snprintf(line, sizeof(line), "\tlet r: i64 = func%u(a + 1, xs[%u]);\n", i - 1, random.Next(16));
+		else
+			std::snprintf(line, sizeof(line), "\tlet r: i64 = xs[%u];\n", random.Next(16));
+		text += line;
+		text += "\treturn r + v3 - v5;\n}\n\n";
+	}
+
+	std::snprintf(line, sizeof(line), "fn main() -> i32\n{\n\tprintf(\"%%ld\\n\", func%u(1, 2));\n\treturn 0;\n}\n", functions - 1);
+	text += line;
+	return text;
+}
+
+// A random expression over the parameters a, b, c and the locals declared so far: every binary operator,
+// parentheses, unary minus and calls, nested up to depth. Divisors are kept in 2..14 so the program runs
+static void AppendExpression(std::string& text, Random& random, unsigned depth, unsigned locals)
+{
+	static const char* const operators[] = { " + ", " - ", " * ", " % ", " == ", " != ", " < ", " <= ", " > ", " >= " };
+	static const char* const parameters[] = { "a", "b", "c" };
+
+	if (depth == 0 || random.Next(5) == 0)
+	{
+		unsigned leaf = random.Next(locals + 4);
+		if (leaf < 3)
+			text += parameters[leaf];
+		else if (leaf == 3)
+			text += std::to_string(random.Next(1000));
+		else
+			text += "e" + std::to_string(leaf - 4);
+		return;
+	}
+
+	switch (random.Next(8))
+	{
+	case 0:
+		text += "(";
+		AppendExpression(text, random, depth - 1, locals);
+		text += ") / ((";
+		AppendExpression(text, random, depth - 1, locals);
+		text += ") % 7 + 8)";
+		break;
+	case 1:
+		text += "-(";
+		AppendExpression(text, random, depth - 1, locals);
+		text += ")";
+		break;
+	case 2:
+		text += "mix(";
+		AppendExpression(text, random, depth - 1, locals);
+		text += ", ";
+		AppendExpression(text, random, depth - 1, locals);
+		text += ")";
+		break;
+	default:
+	{
+		// Unparenthesized chains leave the precedence to the parser
+		bool parenthesized = random.Next(3) == 0;
+		if (parenthesized)
+			text += "(";
+		AppendExpression(text, random, depth - 1, locals);
+		const char* op = operators[random.Next(10)];
+		text += op;
+		// % keeps the divisor nonzero like / does
+		if (op[1] == '%')
+		{
+			text += "((";
+			AppendExpression(text, random, depth - 1, locals);
+			text += ") % 7 + 8)";
+		}
+		else
+			AppendExpression(text, random, depth - 1, locals);
+		if (parenthesized)
+			text += ")";
+	}
+	break;
+	}
+}
+
+// Functions of long, deeply nested expressions, as input for the expression parser
+static std::string GenerateExpressions(unsigned functions)
+{
+	Random random(2);
+	std::string text = "fn extern printf(fmt: i8*, ...) -> i32;\n\nfn mix(x: i64, y: i64) -> i64\n{\n\treturn x * 31 + y;\n}\n\n";
+	for (unsigned i = 0; i < functions; i++)
+	{
+		text += "fn expr" + std::to_string(i) + "(a: i64, b: i64, c: i64) -> i64\n{\n";
+		for (unsigned j = 0; j < 16; j++)
+		{
+			text += "\tlet e" + std::to_string(j) + ": i64 = ";
+			AppendExpression(text, random, 5, j);
+			text += ";\n";
+		}
+		text += "\treturn e15;\n}\n\n";
+	}
+	text += "fn main() -> i32\n{\n\tprintf(\"%ld\\n\", expr" + std::to_string(functions - 1) + "(1, 2, 3));\n\treturn 0;\n}\n";
+	return text;
+}
+
+static FrontEndTimes TimeFrontEnd(const std::string& text, unsigned runs)
+{
+	FrontEndTimes best;
+	for (unsigned run = 0; run < runs; run++)
+	{
+		// Everything is built again, a run measures what a compilation pays
+		StringInterner interner;
+		auto start = std::chrono::steady_clock::now();
+		Tokenizer tokenizer(text, interner);
+		if (!tokenizer.Tokenize())
+			return {};
+		double tokenize = secondsSince(start);
+
+		TokenStream tokens(std::move(tokenizer.getTokens()));
+		size_t tokenCount = tokens.size();
+		start = std::chrono::steady_clock::now();
+		Parser parser(tokens);
+		if (!parser.Parse())
+			return {};
+		double parse = secondsSince(start);
+
+		best.tokens = tokenCount;
+		if (run == 0 || tokenize < best.tokenize)
+			best.tokenize = tokenize;
+		if (run == 0 || parse < best.parse)
+			best.parse = parse;
+	}
+	return best;
+}
+
+static void PrintThroughput(const char* phase, size_t tokens, double seconds)
+{
+	char line[128];
+	std::snprintf(line, sizeof(line), "  %-10s %10.3f ms %10.2f Mtokens/s\n", phase, seconds * 1e3, tokens / seconds / 1e6);
+	std::cout << line;
+}
+
+// Every word of the input the tokenizer classifies, in order: keywords, builtin types and identifiers
+static std::vector<std::string_view> CollectWords(const std::string& text)
+{
+	std::vector<std::string_view> words;
+	StringInterner interner;
+	Tokenizer tokenizer(text, interner);
+	if (!tokenizer.Tokenize())
+		return words;
+	const TokenStream& tokens = tokenizer.getTokens();
+	for (const Token& token : tokens.getTokens())
+	{
+		std::string_view word = tokens.getText(token);
+		if (!word.empty() && isAlphaChar(word[0]) && token.type != TokenType::STRING_LITERAL)
+			words.push_back(word);
+	}
+	return words;
+}
+
+// classifyWord against the map probes it replaced: keywordExist, then isDataType and a lookup of the
+// builtin type for a type. The maps hold the same words, so both give the same classes
+static bool RunKeywordBenchmark(const std::vector<BenchInput>& inputs, unsigned runs)
+{
+	static const char* const keywords[] = {
+		"fn", "in", "let", "for", "const", "return", "extern", "void",
+		"i8", "i16", "i32", "i64", "i128", "u8", "u16", "u32", "u64", "u128", "f32", "f64",
+		"f32x4", "f32x8", "f64x2", "f64x4", "i32x4", "i32x8", "i64x2", "i64x4",
+	};
+	std::unordered_map<std::string_view, TokenType> keywordMap;
+	std::unordered_map<std::string_view, PrimitiveDataType> builtinTypeMap;
+	for (const char* keyword : keywords)
+	{
+		WordClass wordClass = classifyWord(keyword);
+		keywordMap[keyword] = wordClass.type;
+		if (wordClass.type == TokenType::BuiltinType)
+			builtinTypeMap[keyword] = wordClass.dataType;
+	}
+	auto classifyWithMaps = [&](std::string_view word) -> WordClass
+	{
+		auto keyword = keywordMap.find(word);
+		if (keyword == keywordMap.end())
+			return { TokenType::IDENT, PrimitiveDataType::EMPTY };
+		if (builtinTypeMap.find(word) != builtinTypeMap.end())
+			return { keyword->second, builtinTypeMap[word] };
+		return { keyword->second, PrimitiveDataType::EMPTY };
+	};
+
+	char line[256];
+	for (const BenchInput& input : inputs)
+	{
+		std::vector<std::string_view> words = CollectWords(input.text);
+		if (words.empty())
+		{
+			Logger::fmtLog(LogLevel::Error, "Benchmark input '%s' has no words to classify", input.name.c_str());
+			return false;
+		}
+		for (std::string_view word : words)
+		{
+			WordClass expected = classifyWord(word), actual = classifyWithMaps(word);
+			if (expected.type != actual.type || expected.dataType != actual.dataType)
+			{
+				Logger::fmtLog(LogLevel::Error, "The maps classify '%s' differently from classifyWord", std::string(word).c_str());
+				return false;
+			}
+		}
+
+		// The sums keep the classifications from being optimized away
+		volatile uint64_t sink = 0;
+		double bestMaps = 0.0, bestSwitch = 0.0;
+		for (unsigned run = 0; run < runs; run++)
+		{
+			uint64_t sum = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (std::string_view word : words)
+			{
+				WordClass wordClass = classifyWithMaps(word);
+				sum += static_cast<uint64_t>(wordClass.type) + static_cast<uint64_t>(wordClass.dataType);
+			}
+			double maps = secondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			for (std::string_view word : words)
+			{
+				WordClass wordClass = classifyWord(word);
+				sum += static_cast<uint64_t>(wordClass.type) + static_cast<uint64_t>(wordClass.dataType);
+			}
+			double switches = secondsSince(start);
+			sink = sink + sum;
+
+			if (run == 0 || maps < bestMaps)
+				bestMaps = maps;
+			if (run == 0 || switches < bestSwitch)
+				bestSwitch = switches;
+		}
+
+		std::snprintf(line, sizeof(line), "%s: %zu words, best of %u\n", input.name.c_str(), words.size(), runs);
+		std::cout << line;
+		std::snprintf(line, sizeof(line), "  %-14s %8.2f ns/word\n", "map probes", bestMaps * 1e9 / words.size());
+		std::cout << line;
+		std::snprintf(line, sizeof(line), "  %-14s %8.2f ns/word\n", "classifyWord", bestSwitch * 1e9 / words.size());
+		std::cout << line;
+	}
+	return true;
+}
+
+static bool RunFrontEndBenchmark(const std::vector<BenchInput>& inputs, unsigned runs)
+{
+	char line[256];
+	for (const BenchInput& input : inputs)
+	{
+		FrontEndTimes times = TimeFrontEnd(input.text, runs);
+		if (times.tokens == 0)
+		{
+			Logger::fmtLog(LogLevel::Error, "Benchmark input '%s' does not tokenize and parse", input.name.c_str());
+			return false;
+		}
+		std::snprintf(line, sizeof(line), "%s: %.1f MB, %zu tokens, best of %u\n", input.name.c_str(), input.text.size() / (1024.0 * 1024.0),
+			times.tokens, runs);
+		std::cout << line;
+		PrintThroughput("tokenize", times.tokens, times.tokenize);
+		PrintThroughput("parse", times.tokens, times.parse);
+		PrintThroughput("total", times.tokens, times.tokenize + times.parse);
+	}
+	return true;
+}
+
+int RunBenchmark(const CompileOptions& options)
+{
+	std::vector<BenchInput> inputs;
+	for (const std::string& path : options.inputPaths)
+	{
+		SourceFile source;
+		if (!source.Open(path))
+		{
+			Logger::fmtLog(LogLevel::Error, "Failed to open file: %s", path.c_str());
+			return -1;
+		}
+		inputs.push_back({ path, std::string(source.getBuffer()) });
+	}
+	if (inputs.empty())
+	{
+		std::string functions = " (" + std::to_string(options.benchSize) + " functions)";
+		if (options.benchKind == BenchKind::Expressions)
+			inputs.push_back({ "generated expressions" + functions, GenerateExpressions(options.benchSize) });
+		else
+			inputs.push_back({ "generated declarations" + functions, GenerateDeclarations(options.benchSize) });
+	}
+
+	if (!options.outputPath.empty())
+	{
+		std::ofstream out(options.outputPath, std::ios::binary);
+		out << inputs.front().text;
+		if (!out)
+		{
+			Logger::fmtLog(LogLevel::Error, "Failed to write '%s'", options.outputPath.c_str());
+			return -1;
+		}
+		return 0;
+	}
+
+	bool measured = false;
+	switch (options.benchKind)
+	{
+	case BenchKind::Parse:
+	case BenchKind::Expressions:
+		measured = RunFrontEndBenchmark(inputs, options.benchRuns);
+		break;
+	case BenchKind::Keywords:
+		measured = RunKeywordBenchmark(inputs, options.benchRuns);
+		break;
+	}
+	return measured ? 0 : -1;
+}
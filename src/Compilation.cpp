@@ -0,0 +1,192 @@
+#include "headers/Compilation.h"
+#include "headers/ConstantFold.h"
+#include "headers/JIT.h"
+#include "headers/Logger.h"
+#include "headers/Tokenizer.h"
+
+#include <cstdio>
+
+Compilation::Compilation(const CompileOptions& options, const std::string& inputPath, TimeReport& report, CompileCache* cache)
+	: m_options(options), m_inputPath(inputPath), m_report(report), m_cache(cache)
+{
+}
+
+bool Compilation::BuildModule(const std::string& outputPath)
+{
+	// Source is mapped once, tokens point directly into it
+	m_report.BeginPhase("read");
+	bool opened = m_source.Open(resolvePath(m_options, m_inputPath));
+	m_report.EndPhase();
+	if (!opened)
+	{
+		Logger::fmtLog(LogLevel::Error, "Failed to open file: %s", m_inputPath.c_str());
+		return false;
+	}
+
+	// --print-ir needs the module, so it always compiles
+	if (m_cache != nullptr)
+	{
+		m_report.BeginPhase("cache-lookup");
+		m_cacheKey = m_cache->ComputeKey(m_source.getBuffer(), m_options, m_inputPath);
+		m_cacheHit = !m_options.printIR && m_cache->Fetch(m_cacheKey, outputPath, m_cachedFiles);
+		m_report.EndPhase();
+		m_report.SetCount("cache_hits", m_cacheHit ? 1 : 0);
+		if (m_cacheHit)
+			return true;
+	}
+
+	m_report.BeginPhase("tokenize");
+	Tokenizer tokenizer(m_source.getBuffer(), m_interner);
+	bool tokenized = tokenizer.Tokenize();
+	m_report.EndPhase();
+	if (!tokenized)
+		return false;
+	TokenStream tokens(std::move(tokenizer.getTokens()));
+	m_report.SetCount("tokens", tokens.size());
+
+	m_report.BeginPhase("parse");
+	Parser parser(tokens);
+	bool parsed = parser.Parse();
+	m_report.EndPhase();
+	if (!parsed)
+		return false;
+	m_report.SetCount("ast_nodes", parser.getNodeCount());
+	m_program = parser.getProgram();
+
+	m_report.BeginPhase("fold");
+	size_t foldedNodes = FoldConstants(*m_program);
+	m_report.EndPhase();
+	m_report.SetCount("folded_nodes", foldedNodes);
+
+	m_report.BeginPhase("codegen");
+	m_generator = std::make_unique<ShardedGenerator>(*m_program, m_interner, m_inputPath, outputPath, m_options.codegenShards);
+	m_generator->SetConstEvalLimits({ m_options.constEvalSteps, m_options.constEvalMemory });
+	// Textual IR can still be written without a usable target, machine code cannot
+	bool targetReady = m_generator->InitTarget(m_options);
+	if (!targetReady && (m_options.run || m_options.emit != EmitKind::LLVM))
+	{
+		m_report.EndPhase();
+		return false;
+	}
+	bool generated = m_generator->Generate();
+	m_report.EndPhase();
+	if (!generated)
+		return false;
+	m_report.SetCount("codegen_shards", m_generator->getShardCount());
+	m_report.SetCount("ir_instructions", m_generator->getInstructionCount());
+
+	m_report.BeginPhase("verify");
+	bool verified = m_generator->VerifyModules();
+	m_report.EndPhase();
+	if (!verified)
+		return false;
+
+	m_report.BeginPhase("optimize");
+	m_generator->OptimizeModules(m_options.optLevel, m_options.verifyEach);
+	m_report.EndPhase();
+	m_report.SetCount("ir_instructions_optimized", m_generator->getInstructionCount());
+	return true;
+}
+
+bool Compilation::Emit(const std::string& outputPath, std::vector<std::string>& objects)
+{
+	if (m_cacheHit)
+	{
+		if (m_options.emit == EmitKind::Executable)
+			objects.insert(objects.end(), m_cachedFiles.begin(), m_cachedFiles.end());
+		return true;
+	}
+
+	size_t firstObject = objects.size();
+	bool emitted = EmitOutputs(outputPath, objects);
+	if (!emitted || m_cache == nullptr)
+		return emitted;
+
+	// A failed store only costs the next build a miss
+	m_report.BeginPhase("cache-store");
+	if (m_options.emit == EmitKind::Executable)
+		m_cache->Store(m_cacheKey, outputPath, std::vector<std::string>(objects.begin() + firstObject, objects.end()));
+	else
+		m_cache->Store(m_cacheKey, outputPath, { outputPath });
+	m_report.EndPhase();
+	return true;
+}
+
+bool Compilation::EmitOutputs(const std::string& outputPath, std::vector<std::string>& objects)
+{
+	if (m_options.emit == EmitKind::Executable)
+	{
+		// Every shard becomes an object file of its own
+		m_report.BeginPhase("emit");
+		if (m_options.printIR)
+			m_generator->PrintModules(llvm::outs());
+		bool emitted = m_generator->EmitObjects(outputPath, objects);
+		m_report.EndPhase();
+		return emitted;
+	}
+
+	// Every other output is a single file, so the shards are joined first
+	if (m_generator->getShardCount() > 1)
+	{
+		m_report.BeginPhase("merge");
+		bool merged = m_generator->MergeShards();
+		m_report.EndPhase();
+		if (!merged)
+			return false;
+	}
+	Generator& output = m_generator->getMerged();
+
+	m_report.BeginPhase("emit");
+	if (m_options.printIR)
+		output.PrintModule(llvm::outs());
+	bool emitted = false;
+	switch (m_options.emit)
+	{
+	case EmitKind::LLVM:
+		emitted = output.saveModuleToFile();
+		break;
+	case EmitKind::Bitcode:
+		emitted = output.saveBitcodeToFile();
+		break;
+	case EmitKind::Assembly:
+		emitted = output.EmitMachineCode(outputPath, llvm::CGFT_AssemblyFile);
+		break;
+	case EmitKind::Object:
+	case EmitKind::Executable:
+		emitted = output.EmitMachineCode(outputPath, llvm::CGFT_ObjectFile);
+		break;
+	}
+	m_report.EndPhase();
+	return emitted;
+}
+
+int Compilation::Run(const std::vector<std::string>& programArgs)
+{
+	if (m_options.printIR)
+		m_generator->PrintModules(llvm::outs());
+
+	// Eager compiles every module here, a shard per compile thread, lazy only creates the stubs
+	m_report.BeginPhase("jit");
+	JIT jit;
+	unsigned compileThreads = m_generator->getShardCount() > 1 ? static_cast<unsigned>(m_generator->getShardCount()) : 0;
+	bool ready = jit.Init(*m_generator->getTargetMachine(), m_options.lazyJIT, compileThreads);
+	for (auto& module : m_generator->takeModules())
+		ready = ready && jit.AddModule(std::move(module));
+	ready = ready && jit.LookupMain();
+	m_report.EndPhase();
+	if (!ready)
+		return -1;
+
+	m_report.BeginPhase("run");
+	int exitCode = jit.RunMain(m_inputPath, programArgs);
+	m_report.EndPhase();
+
+	// Output of the program comes before anything veritas prints afterwards
+	std::fflush(stdout);
+	return exitCode;
+}
+
+const std::string& Compilation::getInputPath() const
+{
+	return m_inputPath;
+}
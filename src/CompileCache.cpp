@@ -0,0 +1,246 @@
+#include "headers/CompileCache.h"
+#include "headers/Logger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+// Bumped whenever the entry layout changes
+static constexpr char ENTRY_MAGIC[8] = { 'V', 'R', 'S', 'C', 'A', 'C', 'H', '1' };
+
+// Entry layout: magic, key, file count, then per file its suffix and its bytes, each prefixed by its length
+template <typename T>
+static void writeValue(llvm::raw_ostream& out, T value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(llvm::StringRef& data, T& value)
+{
+	if (data.size() < sizeof(T))
+		return false;
+	std::memcpy(&value, data.data(), sizeof(T));
+	data = data.drop_front(sizeof(T));
+	return true;
+}
+
+CompileCache::CompileCache(const std::string& directory, const llvm::CachePruningPolicy& policy)
+	: m_directory(directory), m_policy(policy)
+{
+}
+
+bool CompileCache::Init()
+{
+	if (std::error_code error = llvm::sys::fs::create_directories(m_directory))
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not create the cache directory '%s': %s", m_directory.c_str(), error.message().c_str());
+		return false;
+	}
+
+	static int anchor;
+	std::string executable = llvm::sys::fs::getMainExecutable(nullptr, &anchor);
+	llvm::sys::fs::file_status status;
+	if (executable.empty() || llvm::sys::fs::status(executable, status))
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not identify the compiler binary, the cache is not safe to use");
+		return false;
+	}
+	m_compilerID = executable + '\0' + std::to_string(status.getSize()) + '\0'
+		+ std::to_string(status.getLastModificationTime().time_since_epoch().count());
+	return true;
+}
+
+uint64_t CompileCache::ComputeKey(std::string_view source, const CompileOptions& options, const std::string& inputPath) const
+{
+	// "native" has to be resolved, the same command line means different code on another CI worker
+	std::string cpu = options.cpu;
+	std::string hostFeatures;
+	if (cpu == "native")
+	{
+		cpu = llvm::sys::getHostCPUName().str();
+		llvm::StringMap<bool> features;
+		if (llvm::sys::getHostCPUFeatures(features))
+			for (auto& feature : features)
+				hostFeatures += (feature.second ? "+" : "-") + feature.first().str() + ",";
+	}
+
+	// The input path is part of the output as the module's name
+	std::string material;
+	llvm::raw_string_ostream keyStream(material);
+	keyStream << m_compilerID << '\0' << inputPath << '\0'
+		<< static_cast<int>(options.emit) << '\0' << static_cast<int>(options.optLevel) << '\0'
+		<< options.targetTriple << '\0' << options.arch << '\0' << cpu << '\0' << hostFeatures << '\0'
+		<< options.features << '\0' << options.codegenShards << '\0'
+		<< options.constEvalSteps << '\0' << options.constEvalMemory << '\0';
+	writeValue(keyStream, llvm::xxHash64(llvm::StringRef(source.data(), source.size())));
+	writeValue(keyStream, static_cast<uint64_t>(source.size()));
+	keyStream.flush();
+
+	return llvm::xxHash64(material);
+}
+
+std::string CompileCache::getEntryPath(uint64_t key) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "llvmcache-%016llx", (unsigned long long)key);
+	llvm::SmallString<256> path(m_directory);
+	llvm::sys::path::append(path, name);
+	return path.str().str();
+}
+
+bool CompileCache::Fetch(uint64_t key, const std::string& outputPath, std::vector<std::string>& files)
+{
+	std::string entryPath = getEntryPath(key);
+	auto entry = llvm::MemoryBuffer::getFile(entryPath, false, false);
+	if (!entry)
+	{
+		m_misses++;
+		return false;
+	}
+
+	llvm::StringRef data = (*entry)->getBuffer();
+	uint64_t storedKey = 0;
+	uint32_t fileCount = 0;
+	bool valid = data.startswith(llvm::StringRef(ENTRY_MAGIC, sizeof(ENTRY_MAGIC)));
+	data = data.drop_front(std::min(data.size(), sizeof(ENTRY_MAGIC)));
+	valid = valid && readValue(data, storedKey) && storedKey == key && readValue(data, fileCount);
+
+	// Everything is checked before the first output is written, a broken entry is simply a miss
+	std::vector<std::pair<std::string, llvm::StringRef>> outputs;
+	for (uint32_t i = 0; valid && i < fileCount; i++)
+	{
+		uint32_t suffixSize = 0;
+		uint64_t size = 0;
+		valid = readValue(data, suffixSize) && data.size() >= suffixSize;
+		if (!valid)
+			break;
+		std::string path = outputPath + data.substr(0, suffixSize).str();
+		data = data.drop_front(suffixSize);
+		valid = readValue(data, size) && data.size() >= size;
+		if (valid)
+		{
+			outputs.emplace_back(path, data.substr(0, size));
+			data = data.drop_front(size);
+		}
+	}
+	if (!valid)
+	{
+		Logger::fmtLog(LogLevel::Warning, "Ignoring the corrupt cache entry '%s'", entryPath.c_str());
+		m_misses++;
+		return false;
+	}
+
+	uint64_t served = 0;
+	for (auto& output : outputs)
+	{
+		std::error_code error;
+		llvm::raw_fd_ostream out(output.first, error, llvm::sys::fs::OF_None);
+		if (error)
+		{
+			Logger::fmtLog(LogLevel::Error, "Could not open '%s': %s", output.first.c_str(), error.message().c_str());
+			return false;
+		}
+		out << output.second;
+		files.push_back(output.first);
+		served += output.second.size();
+	}
+
+	// Eviction goes by access time, which many file systems only update lazily
+	int fd = -1;
+	if (!llvm::sys::fs::openFileForWrite(entryPath, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_Append))
+	{
+		llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+		llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+	}
+
+	m_hits++;
+	m_bytesServed += served;
+	return true;
+}
+
+bool CompileCache::Store(uint64_t key, const std::string& outputPath, const std::vector<std::string>& files)
+{
+	std::string entry;
+	llvm::raw_string_ostream entryStream(entry);
+	entryStream.write(ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+	writeValue(entryStream, key);
+	writeValue(entryStream, static_cast<uint32_t>(files.size()));
+	for (const std::string& file : files)
+	{
+		auto contents = llvm::MemoryBuffer::getFile(file, false, false);
+		if (!contents || file.compare(0, outputPath.size(), outputPath) != 0)
+			return false;
+		std::string suffix = file.substr(outputPath.size());
+		writeValue(entryStream, static_cast<uint32_t>(suffix.size()));
+		entryStream << suffix;
+		writeValue(entryStream, static_cast<uint64_t>((*contents)->getBufferSize()));
+		entryStream << (*contents)->getBuffer();
+	}
+	entryStream.flush();
+
+	// Written under a temporary name and renamed, so a concurrent Fetch never reads half an entry
+	llvm::SmallString<256> model(m_directory);
+	llvm::sys::path::append(model, "tmp-%%%%%%%%");
+	int fd = -1;
+	llvm::SmallString<256> tempPath;
+	if (llvm::sys::fs::createUniqueFile(model, fd, tempPath))
+		return false;
+	{
+		llvm::raw_fd_ostream out(fd, true);
+		out << entry;
+		out.close();
+		if (out.has_error())
+		{
+			out.clear_error();
+			llvm::sys::fs::remove(tempPath);
+			return false;
+		}
+	}
+	if (llvm::sys::fs::rename(tempPath, getEntryPath(key)))
+	{
+		llvm::sys::fs::remove(tempPath);
+		return false;
+	}
+
+	m_bytesStored += entry.size();
+	return true;
+}
+
+void CompileCache::Prune()
+{
+	llvm::pruneCache(m_directory, m_policy);
+}
+
+void CompileCache::PrintStats(std::ostream& out) const
+{
+	uint64_t entries = 0, size = 0;
+	std::error_code error;
+	for (llvm::sys::fs::directory_iterator it(m_directory, error), end; it != end && !error; it.increment(error))
+	{
+		if (!llvm::sys::path::filename(it->path()).startswith("llvmcache-"))
+			continue;
+		llvm::sys::fs::file_status status;
+		if (!llvm::sys::fs::status(it->path(), status))
+		{
+			entries++;
+			size += status.getSize();
+		}
+	}
+
+	char line[256];
+	std::snprintf(line, sizeof(line), "cache: %llu hits, %llu misses, %.1f KB served, %.1f KB stored, %llu entries using %.1f KB in '%s'\n",
+		(unsigned long long)m_hits.load(), (unsigned long long)m_misses.load(), m_bytesServed.load() / 1024.0,
+		m_bytesStored.load() / 1024.0, (unsigned long long)entries, size / 1024.0, m_directory.c_str());
+	out << line;
+}
@@ -0,0 +1,599 @@
+#include "headers/ConstEval.h"
+#include "headers/Logger.h"
+
+#include <string>
+
+#include <llvm/ADT/APSInt.h>
+#include <llvm/ADT/SmallVector.h>
+
+// Every call recurses on the native stack, the memory limit alone would not keep it from overflowing
+static constexpr size_t MAX_CALL_DEPTH = 256;
+// Bookkeeping of one call besides its locals
+static constexpr uint64_t FRAME_COST = 256;
+
+// Integer types compute by width only, so unsigned ones are stored as their signed twin.
+// EMPTY for types the evaluator cannot represent
+static PrimitiveDataType getValueType(PrimitiveDataType type)
+{
+	switch (type)
+	{
+	case PrimitiveDataType::i1:
+	case PrimitiveDataType::i8:
+	case PrimitiveDataType::i16:
+	case PrimitiveDataType::i32:
+	case PrimitiveDataType::i64:
+	case PrimitiveDataType::i128:
+	case PrimitiveDataType::f32:
+	case PrimitiveDataType::f64:
+		return type;
+	case PrimitiveDataType::u8:
+		return PrimitiveDataType::i8;
+	case PrimitiveDataType::u16:
+		return PrimitiveDataType::i16;
+	case PrimitiveDataType::u32:
+		return PrimitiveDataType::i32;
+	case PrimitiveDataType::u64:
+		return PrimitiveDataType::i64;
+	case PrimitiveDataType::u128:
+		return PrimitiveDataType::i128;
+	default:
+		return PrimitiveDataType::EMPTY;
+	}
+}
+
+static bool isFloat(PrimitiveDataType type)
+{
+	return type == PrimitiveDataType::f32 || type == PrimitiveDataType::f64;
+}
+
+static unsigned getBitWidth(PrimitiveDataType type)
+{
+	switch (type)
+	{
+	case PrimitiveDataType::i1:		return 1;
+	case PrimitiveDataType::i8:		return 8;
+	case PrimitiveDataType::i16:	return 16;
+	case PrimitiveDataType::i32:	return 32;
+	case PrimitiveDataType::i64:	return 64;
+	default:						return 128;
+	}
+}
+
+static const llvm::fltSemantics& getSemantics(PrimitiveDataType type)
+{
+	return type == PrimitiveDataType::f32 ? llvm::APFloat::IEEEsingle() : llvm::APFloat::IEEEdouble();
+}
+
+// Same order as Generator::getTypePriority
+static int getPriority(PrimitiveDataType type)
+{
+	if (type == PrimitiveDataType::f64)
+		return 164;
+	if (type == PrimitiveDataType::f32)
+		return 132;
+	return static_cast<int>(getBitWidth(type));
+}
+
+static ConstValue makeInt(PrimitiveDataType type, const llvm::APInt& value)
+{
+	ConstValue result;
+	result.type = type;
+	result.intValue = value;
+	return result;
+}
+
+static ConstValue makeBool(bool value)
+{
+	return makeInt(PrimitiveDataType::i1, llvm::APInt(1, value ? 1 : 0));
+}
+
+static ConstValue makeFloat(PrimitiveDataType type, const llvm::APFloat& value)
+{
+	ConstValue result;
+	result.type = type;
+	result.floatValue = value;
+	return result;
+}
+
+// The casts of Generator::autoTypeCast: sext or trunc between integers, sitofp, fptosi and fpcast. Unsigned values
+// and the i1 of comparisons are zero extended and converted with uitofp. type is a declared type, an unsigned one
+// gives its signed twin flagged isUnsigned and converts a float with fptoui
+static bool castTo(const ConstValue& value, PrimitiveDataType type, ConstValue& result)
+{
+	bool isUnsigned = isUnsignedType(type);
+	type = getValueType(type);
+	// result may be value itself
+	bool zeroExtend = value.isUnsigned || value.type == PrimitiveDataType::i1;
+	if (value.type == type)
+	{
+		result = value;
+		result.isUnsigned = isUnsigned;
+		return true;
+	}
+
+	if (!isFloat(type))
+	{
+		if (!isFloat(value.type))
+		{
+			unsigned bits = getBitWidth(type);
+			result = makeInt(type, zeroExtend ? value.intValue.zextOrTrunc(bits) : value.intValue.sextOrTrunc(bits));
+			result.isUnsigned = isUnsigned;
+			return true;
+		}
+		llvm::APSInt integer(getBitWidth(type), isUnsigned);
+		bool isExact = false;
+		if (value.floatValue.convertToInteger(integer, llvm::APFloat::rmTowardZero, &isExact) & llvm::APFloat::opInvalidOp)
+		{
+			Logger::fmtLog(LogLevel::Error, "Constant evaluation: a float value does not fit the integer it is converted to");
+			return false;
+		}
+		result = makeInt(type, integer);
+		result.isUnsigned = isUnsigned;
+		return true;
+	}
+
+	llvm::APFloat converted(getSemantics(type));
+	if (isFloat(value.type))
+	{
+		bool losesInfo = false;
+		converted = value.floatValue;
+		converted.convert(getSemantics(type), llvm::APFloat::rmNearestTiesToEven, &losesInfo);
+	}
+	else
+		converted.convertFromAPInt(value.intValue, !zeroExtend, llvm::APFloat::rmNearestTiesToEven);
+	result = makeFloat(type, converted);
+	return true;
+}
+
+static bool evaluateUnary(TokenType op, const ConstValue& operand, ConstValue& result)
+{
+	if (op != TokenType::MINUS)
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: invalid unary operator");
+		return false;
+	}
+	if (isFloat(operand.type))
+		result = makeFloat(operand.type, llvm::neg(operand.floatValue));
+	else
+		result = makeInt(operand.type, -operand.intValue);
+	return true;
+}
+
+static bool evaluateBinary(TokenType op, ConstValue lhs, ConstValue rhs, ConstValue& result)
+{
+	// Signedness of the operand the other is cast to, a mix of equal priority is unsigned, like Generator::GenerateExpr
+	int lhsPriority = getPriority(lhs.type), rhsPriority = getPriority(rhs.type);
+	bool isUnsigned = lhsPriority > rhsPriority ? lhs.isUnsigned : lhsPriority < rhsPriority ? rhs.isUnsigned : lhs.isUnsigned || rhs.isUnsigned;
+	if (lhsPriority > rhsPriority)
+	{
+		if (!castTo(rhs, lhs.type, rhs))
+			return false;
+	}
+	else if (!castTo(lhs, rhs.type, lhs))
+		return false;
+
+	PrimitiveDataType type = lhs.type;
+	if (isFloat(type))
+	{
+		llvm::APFloat value = lhs.floatValue;
+		llvm::APFloat::cmpResult order = lhs.floatValue.compare(rhs.floatValue);
+		switch (op)
+		{
+		case TokenType::PLUS:			value.add(rhs.floatValue, llvm::APFloat::rmNearestTiesToEven); break;
+		case TokenType::MINUS:			value.subtract(rhs.floatValue, llvm::APFloat::rmNearestTiesToEven); break;
+		case TokenType::STAR:			value.multiply(rhs.floatValue, llvm::APFloat::rmNearestTiesToEven); break;
+		case TokenType::FORWARD_SLASH:	value.divide(rhs.floatValue, llvm::APFloat::rmNearestTiesToEven); break;
+		case TokenType::MODULUS:		value.mod(rhs.floatValue); break;
+		// Ordered comparisons except for !=, like the FCmp predicates Generator uses
+		case TokenType::EQUALITY:		result = makeBool(order == llvm::APFloat::cmpEqual); return true;
+		case TokenType::NOT_EQUAL:		result = makeBool(order != llvm::APFloat::cmpEqual); return true;
+		case TokenType::LESS_THAN:		result = makeBool(order == llvm::APFloat::cmpLessThan); return true;
+		case TokenType::LESS_EQUAL:		result = makeBool(order == llvm::APFloat::cmpLessThan || order == llvm::APFloat::cmpEqual); return true;
+		case TokenType::GREATER_THAN:	result = makeBool(order == llvm::APFloat::cmpGreaterThan); return true;
+		case TokenType::GREATER_EQUAL:	result = makeBool(order == llvm::APFloat::cmpGreaterThan || order == llvm::APFloat::cmpEqual); return true;
+		default:
+			Logger::fmtLog(LogLevel::Error, "Constant evaluation: invalid binary operator");
+			return false;
+		}
+		result = makeFloat(type, value);
+		return true;
+	}
+
+	const llvm::APInt& l = lhs.intValue;
+	const llvm::APInt& r = rhs.intValue;
+	// Only sdiv and srem overflow, for the minimum divided by -1
+	if ((op == TokenType::FORWARD_SLASH || op == TokenType::MODULUS) && (r.isZero() || (!isUnsigned && l.isMinSignedValue() && r.isAllOnes())))
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: %s", r.isZero() ? "division by zero" : "division overflows");
+		return false;
+	}
+	switch (op)
+	{
+	case TokenType::PLUS:			result = makeInt(type, l + r); break;
+	case TokenType::MINUS:			result = makeInt(type, l - r); break;
+	case TokenType::STAR:			result = makeInt(type, l * r); break;
+	case TokenType::FORWARD_SLASH:	result = makeInt(type, isUnsigned ? l.udiv(r) : l.sdiv(r)); break;
+	case TokenType::MODULUS:		result = makeInt(type, isUnsigned ? l.urem(r) : l.srem(r)); break;
+	case TokenType::EQUALITY:		result = makeBool(l == r); break;
+	case TokenType::NOT_EQUAL:		result = makeBool(l != r); break;
+	case TokenType::LESS_THAN:		result = makeBool(isUnsigned ? l.ult(r) : l.slt(r)); break;
+	case TokenType::LESS_EQUAL:		result = makeBool(isUnsigned ? l.ule(r) : l.sle(r)); break;
+	case TokenType::GREATER_THAN:	result = makeBool(isUnsigned ? l.ugt(r) : l.sgt(r)); break;
+	case TokenType::GREATER_EQUAL:	result = makeBool(isUnsigned ? l.uge(r) : l.sge(r)); break;
+	default:
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: invalid binary operator");
+		return false;
+	}
+	result.isUnsigned = isUnsigned;
+	return true;
+}
+
+ConstEvaluator::ConstEvaluator(const Program& program, const StringInterner& interner, const ConstEvalLimits& limits)
+	: m_interner(interner), m_limits(limits)
+{
+	// Non const functions are kept too, calling one gets a better message than an unknown name
+	for (const FnStmt* fnStmt : program.FnStmts)
+	{
+		auto& function = m_functions[fnStmt->name];
+		if (function == nullptr || fnStmt->compoundStmt != nullptr)
+			function = fnStmt;
+	}
+}
+
+bool ConstEvaluator::Evaluate(const Expr* expr, PrimitiveDataType type, Resolver resolve, ConstValue& result)
+{
+	PrimitiveDataType valueType = getValueType(type);
+	if (valueType == PrimitiveDataType::EMPTY)
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: only integer and float constants are supported");
+		return false;
+	}
+
+	m_resolve = resolve;
+	m_steps = 0;
+	m_memory = 0;
+	m_locals.clear();
+	m_frameBase = 0;
+	m_callDepth = 0;
+
+	ConstValue value;
+	bool evaluated = EvaluateExpr(expr, value) && castTo(value, type, result);
+	m_resolve = nullptr;
+	return evaluated;
+}
+
+bool ConstEvaluator::EvaluateExpr(const Expr* expr, ConstValue& result)
+{
+	// Operands precede their users, one forward pass like Generator::GenerateExpr
+	size_t count = expr->nodes.size();
+	uint64_t bytes = count * sizeof(ConstValue);
+	if (!Charge(bytes))
+		return false;
+	llvm::SmallVector<ConstValue, 8> values(count);
+
+	bool evaluated = true;
+	for (size_t i = 0; evaluated && i < count; i++)
+	{
+		const ExprNode& node = expr->nodes[i];
+		evaluated = Step();
+		if (!evaluated)
+			break;
+
+		switch (node.kind)
+		{
+		case ExprKind::Literal:
+			switch (node.literal->type)
+			{
+			case PrimitiveDataType::i32:
+				values[i] = makeInt(PrimitiveDataType::i32, llvm::APInt(32, llvm::StringRef(node.literal->value.data(), node.literal->value.size()), 10));
+				values[i].isUnsigned = isUnsignedLiteral(node.literal);
+				break;
+			case PrimitiveDataType::i1:
+				values[i] = makeBool(node.literal->value == "1");
+				break;
+			case PrimitiveDataType::f64:
+				values[i] = makeFloat(PrimitiveDataType::f64, llvm::APFloat(std::stod(std::string(node.literal->value))));
+				break;
+			default:
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: strings are not supported");
+				evaluated = false;
+				break;
+			}
+			break;
+		case ExprKind::Ident:
+			if (Local* local = FindLocal(node.name))
+				values[i] = local->value;
+			else if (!m_resolve || !m_resolve(node.name, m_callDepth > 0, values[i]))
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' is not a constant", m_interner.getString(node.name).data());
+				evaluated = false;
+			}
+			break;
+		case ExprKind::Call:
+			evaluated = Call(node.call, values[i]);
+			break;
+		case ExprKind::Unary:
+			evaluated = evaluateUnary(node.op, values[node.lhs], values[i]);
+			break;
+		case ExprKind::Binary:
+			evaluated = evaluateBinary(node.op, values[node.lhs], values[node.rhs], values[i]);
+			break;
+		case ExprKind::Index:
+			Logger::fmtLog(LogLevel::Error, "Constant evaluation: arrays are not supported, '%s' is indexed", m_interner.getString(node.name).data());
+			evaluated = false;
+			break;
+		}
+	}
+
+	if (evaluated)
+		result = values.back();
+	Release(bytes);
+	return evaluated;
+}
+
+bool ConstEvaluator::Call(const FnCall* call, ConstValue& result)
+{
+	const char* name = m_interner.getString(call->name).data();
+	auto function = m_functions.find(call->name);
+	if (function == m_functions.end())
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: call to undeclared function '%s'", name);
+		return false;
+	}
+	const FnStmt* fnStmt = function->second;
+	if (!fnStmt->isConst)
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' is not a const fn", name);
+		return false;
+	}
+	if (m_callDepth >= MAX_CALL_DEPTH)
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: calls nested deeper than %zu in '%s'", MAX_CALL_DEPTH, name);
+		return false;
+	}
+
+	size_t argCount = call->args != nullptr ? call->args->list.size() : 0;
+	if (argCount != fnStmt->params.size())
+	{
+		Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' takes %zu arguments, %zu given", name, fnStmt->params.size(), argCount);
+		return false;
+	}
+
+	// Arguments are evaluated in the caller's frame before the callee's starts
+	llvm::SmallVector<ConstValue, 4> args(argCount);
+	for (size_t i = 0; i < argCount; i++)
+	{
+		const ParamDecl* param = fnStmt->params[i];
+		PrimitiveDataType paramType = getValueType(param->type);
+		if (param->VarArg || paramType == PrimitiveDataType::EMPTY)
+		{
+			Logger::fmtLog(LogLevel::Error, "Constant evaluation: parameter %zu of '%s' is not an integer or float", i + 1, name);
+			return false;
+		}
+		ConstValue arg;
+		if (!EvaluateExpr(call->args->list[i], arg) || !castTo(arg, param->type, args[i]))
+			return false;
+	}
+
+	if (!Charge(FRAME_COST))
+		return false;
+	size_t callerBase = m_frameBase;
+	m_frameBase = m_locals.size();
+	m_callDepth++;
+
+	Flow flow = Flow::Fail;
+	if (Charge(argCount * sizeof(Local)))
+	{
+		for (size_t i = 0; i < argCount; i++)
+			m_locals.push_back({ fnStmt->params[i]->ident, std::move(args[i]) });
+
+		ConstValue returnValue;
+		flow = ExecuteBlock(fnStmt->compoundStmt, returnValue);
+		if (flow == Flow::Next)
+		{
+			Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' ended without returning a value", name);
+			flow = Flow::Fail;
+		}
+		else if (flow == Flow::Return)
+		{
+			if (getValueType(fnStmt->returnType) == PrimitiveDataType::EMPTY)
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' does not return an integer or float", name);
+				flow = Flow::Fail;
+			}
+			else if (!castTo(returnValue, fnStmt->returnType, result))
+				flow = Flow::Fail;
+		}
+	}
+
+	Release(FRAME_COST + (m_locals.size() - m_frameBase) * sizeof(Local));
+	m_locals.resize(m_frameBase);
+	m_frameBase = callerBase;
+	m_callDepth--;
+	return flow == Flow::Return;
+}
+
+ConstEvaluator::Flow ConstEvaluator::ExecuteBlock(const CompoundStmt* block, ConstValue& returnValue)
+{
+	// Locals declared in the block go out of scope with it
+	size_t scopeStart = m_locals.size();
+	Flow flow = Flow::Next;
+	for (const Stmt* stmt : block->statementList)
+	{
+		flow = ExecuteStatement(stmt, returnValue);
+		if (flow != Flow::Next)
+			break;
+	}
+	Release((m_locals.size() - scopeStart) * sizeof(Local));
+	m_locals.resize(scopeStart);
+	return flow;
+}
+
+ConstEvaluator::Flow ConstEvaluator::ExecuteStatement(const Stmt* stmt, ConstValue& returnValue)
+{
+	if (!Step())
+		return Flow::Fail;
+
+	struct stmtVisitor
+	{
+		Flow operator()(const DeclStmt* declStmt)
+		{
+			if (getValueType(declStmt->type) == PrimitiveDataType::EMPTY || declStmt->arrayLength != 0)
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: '%s' is not an integer or float", eval.m_interner.getString(declStmt->IDENT).data());
+				return Flow::Fail;
+			}
+			ConstValue value, converted;
+			if (!eval.EvaluateExpr(declStmt->expr, value) || !castTo(value, declStmt->type, converted) || !eval.Charge(sizeof(Local)))
+				return Flow::Fail;
+			eval.m_locals.push_back({ declStmt->IDENT, std::move(converted) });
+			return Flow::Next;
+		}
+		Flow operator()(const AssignStmt* assignStmt)
+		{
+			Local* local = eval.FindLocal(assignStmt->ident);
+			if (local == nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: cannot assign to '%s', it is not a local of the const fn",
+					eval.m_interner.getString(assignStmt->ident).data());
+				return Flow::Fail;
+			}
+			if (local->isLoopVariable || assignStmt->index != nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: cannot assign to %s '%s'", local->isLoopVariable ? "the loop variable" : "an element of",
+					eval.m_interner.getString(assignStmt->ident).data());
+				return Flow::Fail;
+			}
+			ConstValue value;
+			if (!eval.EvaluateExpr(assignStmt->value, value))
+				return Flow::Fail;
+			// Evaluating the value may have grown the locals, the slot is looked up again
+			local = eval.FindLocal(assignStmt->ident);
+			bool isUnsigned = local->value.isUnsigned;
+			if (!castTo(value, local->value.type, local->value))
+				return Flow::Fail;
+			// The local keeps the signedness it was declared with
+			local->value.isUnsigned = isUnsigned;
+			return Flow::Next;
+		}
+		Flow operator()(const ReturnStmt* retStmt)
+		{
+			if (retStmt->value == nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Constant evaluation: a const fn has to return a value");
+				return Flow::Fail;
+			}
+			return eval.EvaluateExpr(retStmt->value, returnValue) ? Flow::Return : Flow::Fail;
+		}
+		Flow operator()(const CompoundStmt* compoundStmt)
+		{
+			return eval.ExecuteBlock(compoundStmt, returnValue);
+		}
+		Flow operator()(const FnCall* fnCall)
+		{
+			ConstValue ignored;
+			return eval.Call(fnCall, ignored) ? Flow::Next : Flow::Fail;
+		}
+		Flow operator()(const ForStmt* forStmt)
+		{
+			// Same as the generated loop: signed i64 counter, bounds sign extended unless unsigned, end evaluated once
+			ConstValue start, end;
+			if (!eval.EvaluateExpr(forStmt->start, start) || !castTo(start, PrimitiveDataType::i64, start))
+				return Flow::Fail;
+			if (!eval.EvaluateExpr(forStmt->end, end) || !castTo(end, PrimitiveDataType::i64, end))
+				return Flow::Fail;
+			if (!eval.Charge(sizeof(Local)))
+				return Flow::Fail;
+
+			size_t slot = eval.m_locals.size();
+			eval.m_locals.push_back({ forStmt->ident, std::move(start), true });
+			Flow flow = Flow::Next;
+			// The slot is indexed, the body may grow the locals
+			while (eval.m_locals[slot].value.intValue.slt(end.intValue))
+			{
+				if (!eval.Step())
+				{
+					flow = Flow::Fail;
+					break;
+				}
+				flow = eval.ExecuteBlock(forStmt->body, returnValue);
+				if (flow != Flow::Next)
+					break;
+				++eval.m_locals[slot].value.intValue;
+			}
+			eval.Release(sizeof(Local));
+			eval.m_locals.resize(slot);
+			return flow;
+		}
+		ConstEvaluator& eval;
+		ConstValue& returnValue;
+	};
+	return std::visit(stmtVisitor{ *this, returnValue }, stmt->stmt);
+}
+
+bool ConstEvaluator::Step()
+{
+	if (++m_steps <= m_limits.maxSteps)
+		return true;
+	Logger::fmtLog(LogLevel::Error, "Constant evaluation: exceeded the limit of %llu steps (--const-eval-steps)", (unsigned long long)m_limits.maxSteps);
+	return false;
+}
+
+bool ConstEvaluator::Charge(uint64_t bytes)
+{
+	m_memory += bytes;
+	if (m_memory <= m_limits.maxMemory)
+		return true;
+	m_memory -= bytes;
+	Logger::fmtLog(LogLevel::Error, "Constant evaluation: exceeded the limit of %llu bytes (--const-eval-memory)", (unsigned long long)m_limits.maxMemory);
+	return false;
+}
+
+void ConstEvaluator::Release(uint64_t bytes)
+{
+	m_memory -= bytes;
+}
+
+ConstEvaluator::Local* ConstEvaluator::FindLocal(SymbolID name)
+{
+	// Innermost declaration first, only the locals of the current call are visible
+	for (size_t i = m_locals.size(); i > m_frameBase; i--)
+		if (m_locals[i - 1].name == name)
+			return &m_locals[i - 1];
+	return nullptr;
+}
+
+llvm::Constant* ConstEvaluator::toConstant(const ConstValue& value, llvm::LLVMContext& ctx)
+{
+	if (isFloat(value.type))
+		return llvm::ConstantFP::get(ctx, value.floatValue);
+	return llvm::ConstantInt::get(ctx, value.intValue);
+}
+
+bool ConstEvaluator::fromConstant(const llvm::Constant* constant, ConstValue& value)
+{
+	if (auto* constInt = llvm::dyn_cast<llvm::ConstantInt>(constant))
+	{
+		switch (constInt->getBitWidth())
+		{
+		case 1:		value.type = PrimitiveDataType::i1; break;
+		case 8:		value.type = PrimitiveDataType::i8; break;
+		case 16:	value.type = PrimitiveDataType::i16; break;
+		case 32:	value.type = PrimitiveDataType::i32; break;
+		case 64:	value.type = PrimitiveDataType::i64; break;
+		case 128:	value.type = PrimitiveDataType::i128; break;
+		default:	return false;
+		}
+		value.intValue = constInt->getValue();
+		return true;
+	}
+	if (auto* constFP = llvm::dyn_cast<llvm::ConstantFP>(constant))
+	{
+		if (!constFP->getType()->isFloatTy() && !constFP->getType()->isDoubleTy())
+			return false;
+		value.type = constFP->getType()->isFloatTy() ? PrimitiveDataType::f32 : PrimitiveDataType::f64;
+		value.floatValue = constFP->getValueAPF();
+		return true;
+	}
+	return false;
+}
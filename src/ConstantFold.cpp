@@ -0,0 +1,357 @@
+#include "headers/ConstantFold.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <llvm/ADT/SmallVector.h>
+
+namespace
+{
+	// A node's value if it is constant. Literals only have three types: i32, f64 and the i1 of comparisons
+	struct FoldedValue
+	{
+		PrimitiveDataType type = PrimitiveDataType::EMPTY;
+		int64_t intValue = 0;	// Sign extended from the width of type, so i1 true is -1
+		double floatValue = 0.0;
+		// An i32 above INT32_MAX, see isUnsignedLiteral
+		bool isUnsigned = false;
+
+		bool isConstant() const { return type != PrimitiveDataType::EMPTY; }
+		bool isFloat() const { return type == PrimitiveDataType::f64; }
+	};
+}
+
+static unsigned getBitWidth(PrimitiveDataType type)
+{
+	return type == PrimitiveDataType::i1 ? 1 : 32;
+}
+
+// Same order as Generator::getTypePriority, the operand of lower priority is cast to the other's type
+static int getPriority(PrimitiveDataType type)
+{
+	switch (type)
+	{
+	case PrimitiveDataType::i1:
+		return 1;
+	case PrimitiveDataType::i32:
+		return 32;
+	default:
+		return 164;
+	}
+}
+
+// Truncates to bits and sign extends back, what two's complement arithmetic of that width gives
+static int64_t wrap(int64_t value, unsigned bits)
+{
+	uint64_t mask = (uint64_t(1) << bits) - 1;
+	uint64_t truncated = static_cast<uint64_t>(value) & mask;
+	if ((truncated >> (bits - 1)) & 1)
+		truncated |= ~mask;
+	return static_cast<int64_t>(truncated);
+}
+
+static FoldedValue makeInt(PrimitiveDataType type, int64_t value)
+{
+	FoldedValue result;
+	result.type = type;
+	result.intValue = wrap(value, getBitWidth(type));
+	return result;
+}
+
+static FoldedValue makeFloat(double value)
+{
+	FoldedValue result;
+	result.type = PrimitiveDataType::f64;
+	result.floatValue = value;
+	return result;
+}
+
+static FoldedValue readLiteral(const Literal* literal)
+{
+	std::string text(literal->value);
+	char* end = nullptr;
+	errno = 0;
+
+	switch (literal->type)
+	{
+	case PrimitiveDataType::i1:
+		return makeInt(PrimitiveDataType::i1, text == "1" ? 1 : 0);
+	case PrimitiveDataType::i32:
+	{
+		// Anything that does not fit 32 bits is left to Generator
+		long long value = std::strtoll(text.c_str(), &end, 10);
+		if (errno != 0 || *end != '\0' || value < INT32_MIN || value > UINT32_MAX)
+			return {};
+		FoldedValue result = makeInt(PrimitiveDataType::i32, value);
+		result.isUnsigned = isUnsignedLiteral(literal);
+		return result;
+	}
+	case PrimitiveDataType::f64:
+	{
+		double value = std::strtod(text.c_str(), &end);
+		if (errno != 0 || *end != '\0')
+			return {};
+		return makeFloat(value);
+	}
+	default:
+		return {};
+	}
+}
+
+// The casts autoTypeCast emits for literals: a signed i32 is sign extended and converted as signed, an unsigned
+// one and the i1 of a comparison are zero extended and converted as unsigned
+static FoldedValue castTo(const FoldedValue& value, PrimitiveDataType type)
+{
+	if (value.type == type)
+		return value;
+	int64_t extended = value.intValue;
+	if (value.type == PrimitiveDataType::i1 || value.isUnsigned)
+		extended &= (int64_t(1) << getBitWidth(value.type)) - 1;
+	if (type == PrimitiveDataType::f64)
+		return makeFloat(static_cast<double>(extended));
+	return makeInt(type, extended);
+}
+
+static bool foldUnary(TokenType op, const FoldedValue& operand, FoldedValue& result)
+{
+	if (op != TokenType::MINUS)
+		return false;
+	if (operand.isFloat())
+		result = makeFloat(-operand.floatValue);
+	else
+		result = makeInt(operand.type, -operand.intValue);
+	return true;
+}
+
+static bool foldBinary(TokenType op, FoldedValue lhs, FoldedValue rhs, FoldedValue& result)
+{
+	// Signedness of the operand the other is cast to, a mix of equal priority is unsigned, like Generator::GenerateExpr
+	int lhsPriority = getPriority(lhs.type), rhsPriority = getPriority(rhs.type);
+	bool isUnsigned = lhsPriority > rhsPriority ? lhs.isUnsigned : lhsPriority < rhsPriority ? rhs.isUnsigned : lhs.isUnsigned || rhs.isUnsigned;
+	if (lhsPriority > rhsPriority)
+		rhs = castTo(rhs, lhs.type);
+	else
+		lhs = castTo(lhs, rhs.type);
+
+	// Comparisons are ordered except for !=, like the FCmp predicates Generator uses
+	if (lhs.isFloat())
+	{
+		double l = lhs.floatValue, r = rhs.floatValue;
+		switch (op)
+		{
+		case TokenType::PLUS:			result = makeFloat(l + r); break;
+		case TokenType::MINUS:			result = makeFloat(l - r); break;
+		case TokenType::STAR:			result = makeFloat(l * r); break;
+		case TokenType::FORWARD_SLASH:	result = makeFloat(l / r); break;
+		case TokenType::MODULUS:		result = makeFloat(std::fmod(l, r)); break;
+		case TokenType::EQUALITY:		result = makeInt(PrimitiveDataType::i1, l == r); break;
+		case TokenType::NOT_EQUAL:		result = makeInt(PrimitiveDataType::i1, l != r); break;
+		case TokenType::LESS_THAN:		result = makeInt(PrimitiveDataType::i1, l < r); break;
+		case TokenType::LESS_EQUAL:		result = makeInt(PrimitiveDataType::i1, l <= r); break;
+		case TokenType::GREATER_THAN:	result = makeInt(PrimitiveDataType::i1, l > r); break;
+		case TokenType::GREATER_EQUAL:	result = makeInt(PrimitiveDataType::i1, l >= r); break;
+		default:
+			return false;
+		}
+		// A literal has to be printable and read back bit for bit
+		return !result.isFloat() || std::isfinite(result.floatValue);
+	}
+
+	PrimitiveDataType type = lhs.type;
+	int64_t l = lhs.intValue, r = rhs.intValue;
+	if (isUnsigned)
+	{
+		// udiv, urem and the unsigned predicates see the zero extended values, which fit an int64_t at these widths
+		int64_t mask = (int64_t(1) << getBitWidth(type)) - 1;
+		l &= mask;
+		r &= mask;
+	}
+	// Division by zero has no defined result, and neither has sdiv or srem of the minimum by -1
+	bool divisionTraps = r == 0 || (!isUnsigned && l == wrap(int64_t(1) << (getBitWidth(type) - 1), getBitWidth(type)) && r == -1);
+	switch (op)
+	{
+	case TokenType::PLUS:			result = makeInt(type, l + r); break;
+	case TokenType::MINUS:			result = makeInt(type, l - r); break;
+	case TokenType::STAR:			result = makeInt(type, l * r); break;
+	case TokenType::FORWARD_SLASH:
+		if (divisionTraps)
+			return false;
+		result = makeInt(type, l / r);
+		break;
+	case TokenType::MODULUS:
+		if (divisionTraps)
+			return false;
+		result = makeInt(type, l % r);
+		break;
+	case TokenType::EQUALITY:		result = makeInt(PrimitiveDataType::i1, l == r); break;
+	case TokenType::NOT_EQUAL:		result = makeInt(PrimitiveDataType::i1, l != r); break;
+	case TokenType::LESS_THAN:		result = makeInt(PrimitiveDataType::i1, l < r); break;
+	case TokenType::LESS_EQUAL:		result = makeInt(PrimitiveDataType::i1, l <= r); break;
+	case TokenType::GREATER_THAN:	result = makeInt(PrimitiveDataType::i1, l > r); break;
+	case TokenType::GREATER_EQUAL:	result = makeInt(PrimitiveDataType::i1, l >= r); break;
+	default:
+		return false;
+	}
+	if (result.type != PrimitiveDataType::i32 || !isUnsigned)
+		return true;
+	// The literal has to read back as unsigned, which only one above INT32_MAX does
+	result.isUnsigned = true;
+	return result.intValue < 0;
+}
+
+static Literal* makeLiteral(Arena& arena, const FoldedValue& value)
+{
+	std::string text;
+	if (value.isFloat())
+	{
+		// 17 significant digits read back as the same double
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.17g", value.floatValue);
+		text = buffer;
+	}
+	else if (value.type == PrimitiveDataType::i1)
+		text = value.intValue != 0 ? "1" : "0";
+	else if (value.isUnsigned)
+		text = std::to_string(static_cast<uint32_t>(value.intValue));
+	else
+		text = std::to_string(value.intValue);
+
+	Literal* literal = arena.New<Literal>();
+	literal->type = value.type;
+	literal->value = arena.CopyString(text);
+	return literal;
+}
+
+static size_t foldExpr(Expr* expr, Arena& arena);
+
+static size_t foldArgs(const FnCall* call, Arena& arena)
+{
+	size_t removed = 0;
+	if (call->args != nullptr)
+		for (Expr* arg : call->args->list)
+			removed += foldExpr(arg, arena);
+	return removed;
+}
+
+static size_t foldExpr(Expr* expr, Arena& arena)
+{
+	size_t count = expr->nodes.size();
+	llvm::SmallVector<FoldedValue, 32> values(count);
+	size_t removed = 0;
+	bool folded = false;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const ExprNode& node = expr->nodes[i];
+		switch (node.kind)
+		{
+		case ExprKind::Literal:
+			values[i] = readLiteral(node.literal);
+			break;
+		case ExprKind::Call:
+			removed += foldArgs(node.call, arena);
+			break;
+		case ExprKind::Unary:
+			if (values[node.lhs].isConstant())
+				folded |= foldUnary(node.op, values[node.lhs], values[i]);
+			break;
+		case ExprKind::Binary:
+			if (values[node.lhs].isConstant() && values[node.rhs].isConstant())
+				folded |= foldBinary(node.op, values[node.lhs], values[node.rhs], values[i]);
+			break;
+		default:
+			break;
+		}
+	}
+	if (!folded)
+		return removed;
+
+	// Operands of a folded node are dropped, nodes stay in post-order so they are compacted in place
+	llvm::SmallVector<char, 32> absorbed(count, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		const ExprNode& node = expr->nodes[i];
+		if (!values[i].isConstant() || node.kind == ExprKind::Literal)
+			continue;
+		absorbed[node.lhs] = 1;
+		if (node.kind == ExprKind::Binary)
+			absorbed[node.rhs] = 1;
+	}
+
+	llvm::SmallVector<uint32_t, 32> newIndex(count);
+	uint32_t kept = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (absorbed[i])
+			continue;
+
+		ExprNode node = expr->nodes[i];
+		if (values[i].isConstant() && node.kind != ExprKind::Literal)
+		{
+			node = ExprNode{ ExprKind::Literal };
+			node.literal = makeLiteral(arena, values[i]);
+		}
+		else if (node.kind == ExprKind::Unary || node.kind == ExprKind::Binary || node.kind == ExprKind::Index)
+		{
+			node.lhs = newIndex[node.lhs];
+			node.rhs = node.kind == ExprKind::Binary ? newIndex[node.rhs] : 0;
+		}
+		expr->nodes[kept] = node;
+		newIndex[i] = kept++;
+	}
+
+	removed += count - kept;
+	expr->nodes.count = kept;
+	return removed;
+}
+
+static size_t foldCompound(const CompoundStmt* compoundStmt, Arena& arena)
+{
+	size_t removed = 0;
+	for (const Stmt* stmt : compoundStmt->statementList)
+	{
+		if (auto declStmt = std::get_if<DeclStmt*>(&stmt->stmt))
+		{
+			if ((*declStmt)->expr != nullptr)
+				removed += foldExpr((*declStmt)->expr, arena);
+		}
+		else if (auto assignStmt = std::get_if<AssignStmt*>(&stmt->stmt))
+		{
+			if ((*assignStmt)->index != nullptr)
+				removed += foldExpr((*assignStmt)->index, arena);
+			removed += foldExpr((*assignStmt)->value, arena);
+		}
+		else if (auto retStmt = std::get_if<ReturnStmt*>(&stmt->stmt))
+		{
+			if ((*retStmt)->value != nullptr)
+				removed += foldExpr((*retStmt)->value, arena);
+		}
+		else if (auto fnCall = std::get_if<FnCall*>(&stmt->stmt))
+			removed += foldArgs(*fnCall, arena);
+		else if (auto nested = std::get_if<CompoundStmt*>(&stmt->stmt))
+			removed += foldCompound(*nested, arena);
+		else if (auto forStmt = std::get_if<ForStmt*>(&stmt->stmt))
+		{
+			removed += foldExpr((*forStmt)->start, arena);
+			removed += foldExpr((*forStmt)->end, arena);
+			removed += foldCompound((*forStmt)->body, arena);
+		}
+	}
+	return removed;
+}
+
+size_t FoldConstants(Program& program)
+{
+	size_t removed = 0;
+	for (DeclStmt* declStmt : program.DeclStmts)
+		if (declStmt->expr != nullptr)
+			removed += foldExpr(declStmt->expr, program.arena);
+
+	for (FnStmt* fnStmt : program.FnStmts)
+		if (fnStmt->compoundStmt != nullptr)
+			removed += foldCompound(fnStmt->compoundStmt, program.arena);
+	return removed;
+}
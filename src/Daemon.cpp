@@ -0,0 +1,323 @@
+#include "headers/Daemon.h"
+#include "headers/Driver.h"
+#include "headers/Generate.h"
+#include "headers/Logger.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Every message is a native endian uint32 length followed by that many bytes.
+// Request:  "VRS1\0" <working directory> '\0' then each argument followed by '\0'
+// Response: "VRS1" <int32 exit code> <uint32 log length> <log> <report>, the report is the rest of the message
+static constexpr char PROTOCOL_MAGIC[4] = { 'V', 'R', 'S', '1' };
+// Far more than any command line, stops a stray client from making the daemon allocate gigabytes
+static constexpr uint32_t MAX_REQUEST_SIZE = 16u * 1024 * 1024;
+
+std::string getDefaultSocketPath()
+{
+	if (const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR"); runtimeDir != nullptr && *runtimeDir != '\0')
+		return (std::filesystem::path(runtimeDir) / "veritasd.sock").string();
+#ifdef _WIN32
+	return (std::filesystem::temp_directory_path() / "veritasd.sock").string();
+#else
+	return "/tmp/veritasd-" + std::to_string(getuid()) + ".sock";
+#endif
+}
+
+#ifdef _WIN32
+
+int RunDaemon(const CompileOptions& options)
+{
+	Logger::fmtLog(LogLevel::Error, "The compile daemon is not supported on Windows");
+	return -1;
+}
+
+bool CompileWithDaemon(const CompileOptions& options, int argc, char* argv[], int& exitCode)
+{
+	return false;
+}
+
+#else
+
+static bool writeAll(int fd, const char* data, size_t size)
+{
+	while (size != 0)
+	{
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+static bool readAll(int fd, char* data, size_t size)
+{
+	while (size != 0)
+	{
+		ssize_t count = ::read(fd, data, size);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			return false;
+		data += count;
+		size -= count;
+	}
+	return true;
+}
+
+static bool sendMessage(int fd, const std::string& message)
+{
+	uint32_t size = static_cast<uint32_t>(message.size());
+	return writeAll(fd, reinterpret_cast<const char*>(&size), sizeof(size)) && writeAll(fd, message.data(), message.size());
+}
+
+static bool receiveMessage(int fd, std::string& message, uint32_t maxSize)
+{
+	uint32_t size = 0;
+	if (!readAll(fd, reinterpret_cast<char*>(&size), sizeof(size)) || size > maxSize)
+		return false;
+	message.resize(size);
+	return readAll(fd, message.data(), size);
+}
+
+// Returns a socket connected to path, or -1
+static int connectTo(const std::string& path)
+{
+	sockaddr_un address = {};
+	if (path.size() >= sizeof(address.sun_path))
+		return -1;
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// Handlers may only call async signal safe functions, hence the fixed buffer
+static char g_socketPath[sizeof(sockaddr_un::sun_path)];
+
+static void removeSocketAndExit(int)
+{
+	::unlink(g_socketPath);
+	_exit(0);
+}
+
+// Compiles one request on the calling thread, everything the build logs or reports ends up in the response
+static std::string HandleRequest(const std::string& request, llvm::ThreadPool& pool)
+{
+	LogSink sink;
+	std::ostringstream report;
+	int exitCode = -1;
+
+	Logger::SetThreadSink(&sink);
+	if (request.size() < sizeof(PROTOCOL_MAGIC) + 1 || request.compare(0, sizeof(PROTOCOL_MAGIC), PROTOCOL_MAGIC, sizeof(PROTOCOL_MAGIC)) != 0)
+		Logger::fmtLog(LogLevel::Error, "The daemon received a request from an incompatible client");
+	else
+	{
+		// The working directory and then the arguments, each ends with '\0'
+		std::vector<std::string> strings;
+		size_t start = sizeof(PROTOCOL_MAGIC) + 1;
+		while (start < request.size())
+		{
+			size_t end = request.find('\0', start);
+			if (end == std::string::npos)
+				end = request.size();
+			strings.push_back(request.substr(start, end - start));
+			start = end + 1;
+		}
+
+		std::vector<char*> argv;
+		std::string programName = "veritas";
+		argv.push_back(programName.data());
+		for (size_t i = 1; i < strings.size(); i++)
+			argv.push_back(strings[i].data());
+
+		CompileOptions options;
+		if (strings.empty() || !ParseCommandLine(static_cast<int>(argv.size()), argv.data(), options))
+			PrintUsage();
+		else if (options.showHelp)
+		{
+			PrintUsage();
+			exitCode = 0;
+		}
+		else if (options.run || options.printIR || options.daemon || options.bench)
+			Logger::fmtLog(LogLevel::Error, "run, bench, --print-ir and daemon are not handled by the daemon");
+		else if (options.inputPaths.empty())
+			Logger::Log(LogLevel::Error, "No input file given");
+		else
+		{
+			options.workingDirectory = strings[0];
+			exitCode = BuildFiles(options, report, &pool);
+		}
+	}
+	Logger::SetThreadSink(nullptr);
+
+	std::string log = sink.Take();
+	std::string reportText = report.str();
+	int32_t code = exitCode;
+	uint32_t logSize = static_cast<uint32_t>(log.size());
+	std::string response(PROTOCOL_MAGIC, sizeof(PROTOCOL_MAGIC));
+	response.append(reinterpret_cast<const char*>(&code), sizeof(code));
+	response.append(reinterpret_cast<const char*>(&logSize), sizeof(logSize));
+	response += log;
+	response += reportText;
+	return response;
+}
+
+int RunDaemon(const CompileOptions& options)
+{
+	std::string socketPath = options.socketPath.empty() ? getDefaultSocketPath() : options.socketPath;
+	sockaddr_un address = {};
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		Logger::fmtLog(LogLevel::Error, "Socket path '%s' is too long", socketPath.c_str());
+		return -1;
+	}
+
+	// A socket file nobody answers on is left over from a daemon that was killed
+	int existing = connectTo(socketPath);
+	if (existing >= 0)
+	{
+		::close(existing);
+		Logger::fmtLog(LogLevel::Error, "A daemon is already listening on '%s'", socketPath.c_str());
+		return -1;
+	}
+	::unlink(socketPath.c_str());
+
+	int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+	if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not listen on '%s': %s", socketPath.c_str(), std::strerror(errno));
+		if (listener >= 0)
+			::close(listener);
+		return -1;
+	}
+
+	std::memcpy(g_socketPath, socketPath.c_str(), socketPath.size() + 1);
+	std::signal(SIGINT, removeSocketAndExit);
+	std::signal(SIGTERM, removeSocketAndExit);
+	// A client that went away must not take the daemon with it
+	std::signal(SIGPIPE, SIG_IGN);
+
+	// The state every request would otherwise build again
+	Generator::InitializeTargets();
+	unsigned jobs = options.jobs == 0 ? llvm::hardware_concurrency().compute_thread_count() : options.jobs;
+	llvm::ThreadPoolStrategy strategy = llvm::hardware_concurrency(jobs);
+	strategy.Limit = true;
+	llvm::ThreadPool pool(strategy);
+	// Client threads are detached but use pool, so it is only destroyed once every one of them is done
+	std::mutex clientsMutex;
+	std::condition_variable clientsDone;
+	unsigned activeClients = 0;
+
+	Logger::fmtLog(LogLevel::Info, "veritasd listening on '%s' with %u threads", socketPath.c_str(), jobs);
+	while (true)
+	{
+		int client = ::accept(listener, nullptr, nullptr);
+		if (client < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			Logger::fmtLog(LogLevel::Error, "Accepting a connection failed: %s", std::strerror(errno));
+			break;
+		}
+
+		// Each client waits on its own thread while its files are compiled on the shared pool
+		{
+			std::lock_guard<std::mutex> lock(clientsMutex);
+			activeClients++;
+		}
+		std::thread([client, &pool, &clientsMutex, &clientsDone, &activeClients]
+		{
+			std::string request;
+			if (receiveMessage(client, request, MAX_REQUEST_SIZE))
+				sendMessage(client, HandleRequest(request, pool));
+			::close(client);
+			// Notified under the lock, RunDaemon cannot return before this thread let go of it
+			std::lock_guard<std::mutex> lock(clientsMutex);
+			if (--activeClients == 0)
+				clientsDone.notify_all();
+		}).detach();
+	}
+
+	::close(listener);
+	::unlink(socketPath.c_str());
+	std::unique_lock<std::mutex> lock(clientsMutex);
+	clientsDone.wait(lock, [&activeClients] { return activeClients == 0; });
+	return -1;
+}
+
+bool CompileWithDaemon(const CompileOptions& options, int argc, char* argv[], int& exitCode)
+{
+	std::string socketPath = options.socketPath.empty() ? getDefaultSocketPath() : options.socketPath;
+	int fd = connectTo(socketPath);
+	if (fd < 0)
+		return false;
+
+	std::error_code error;
+	std::string request(PROTOCOL_MAGIC, sizeof(PROTOCOL_MAGIC));
+	request += '\0';
+	request += std::filesystem::current_path(error).string();
+	request += '\0';
+	for (int i = 1; i < argc; i++)
+	{
+		request += argv[i];
+		request += '\0';
+	}
+
+	std::string response;
+	constexpr size_t headerSize = sizeof(PROTOCOL_MAGIC) + sizeof(int32_t) + sizeof(uint32_t);
+	bool answered = sendMessage(fd, request) && receiveMessage(fd, response, UINT32_MAX) && response.size() >= headerSize
+		&& response.compare(0, sizeof(PROTOCOL_MAGIC), PROTOCOL_MAGIC, sizeof(PROTOCOL_MAGIC)) == 0;
+	::close(fd);
+	if (!answered)
+	{
+		Logger::fmtLog(LogLevel::Warning, "The daemon on '%s' did not answer, compiling in-process", socketPath.c_str());
+		return false;
+	}
+
+	int32_t code = 0;
+	uint32_t logSize = 0;
+	std::memcpy(&code, response.data() + sizeof(PROTOCOL_MAGIC), sizeof(code));
+	std::memcpy(&logSize, response.data() + sizeof(PROTOCOL_MAGIC) + sizeof(code), sizeof(logSize));
+	if (logSize > response.size() - headerSize)
+		logSize = static_cast<uint32_t>(response.size() - headerSize);
+
+	// Same streams as an in-process build: the log on stdout, reports on stderr
+	std::cout.write(response.data() + headerSize, logSize);
+	std::cout.flush();
+	std::cerr.write(response.data() + headerSize + logSize, response.size() - headerSize - logSize);
+	exitCode = code;
+	return true;
+}
+
+#endif // _WIN32
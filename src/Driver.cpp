@@ -0,0 +1,153 @@
+#include "headers/Driver.h"
+#include "headers/Compilation.h"
+#include "headers/CompileCache.h"
+#include "headers/Link.h"
+#include "headers/Logger.h"
+#include "headers/TimeReport.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <set>
+
+static void PrintReport(const CompileOptions& options, const TimeReport& report, std::ostream& reportOut)
+{
+	if (options.timeReport == ReportFormat::Text)
+		report.PrintText(reportOut);
+	else if (options.timeReport == ReportFormat::JSON)
+		report.PrintJSON(reportOut);
+}
+
+int RunFile(const CompileOptions& options, std::ostream& reportOut)
+{
+	// Phases are always measured, the report is only printed on request
+	TimeReport::AllocationCounting counting(options.timeReport != ReportFormat::None);
+	TimeReport report;
+	Compilation compilation(options, options.inputPaths[0], report);
+	int exitCode = compilation.BuildModule(std::string()) ? compilation.Run(options.programArgs) : -1;
+	PrintReport(options, report, reportOut);
+	return exitCode;
+}
+
+int BuildFiles(const CompileOptions& options, std::ostream& reportOut, llvm::ThreadPool* pool)
+{
+	const std::vector<std::string>& inputs = options.inputPaths;
+	bool multiFile = inputs.size() > 1;
+	bool linking = options.emit == EmitKind::Executable;
+	TimeReport::AllocationCounting counting(options.timeReport != ReportFormat::None);
+
+	// An executable is named after the first file, its objects after the executable
+	std::string exeFile = linking ? resolvePath(options, getOutputPath(options, inputs[0])) : std::string();
+	std::vector<std::string> outputs(inputs.size());
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		if (linking)
+			outputs[i] = multiFile ? exeFile + "." + std::to_string(i) : exeFile;
+		else
+			outputs[i] = resolvePath(options, getOutputPath(options, inputs[i]));
+	}
+	if (!linking && multiFile)
+	{
+		std::set<std::string> distinct(outputs.begin(), outputs.end());
+		if (distinct.size() != outputs.size())
+		{
+			Logger::fmtLog(LogLevel::Error, "Several input files have the same name and would overwrite each other's output");
+			return -1;
+		}
+	}
+
+	std::unique_ptr<CompileCache> cache;
+	if (!options.cacheDir.empty())
+	{
+		llvm::CachePruningPolicy policy;
+		policy.MaxSizeBytes = 1024ull * 1024 * 1024;
+		// Validated by ParseCommandLine
+		if (!options.cachePolicy.empty())
+			policy = llvm::cantFail(llvm::parseCachePruningPolicy(options.cachePolicy));
+		cache = std::make_unique<CompileCache>(resolvePath(options, options.cacheDir), policy);
+		if (!cache->Init())
+			return -1;
+	}
+
+	// Files compiled side by side are each only charged for their own thread
+	std::vector<TimeReport> reports(inputs.size(), TimeReport(multiFile));
+	std::vector<std::vector<std::string>> objects(inputs.size());
+	// Not a vector<bool>, every worker writes its own element
+	std::vector<char> succeeded(inputs.size(), 0);
+	// Workers log to wherever the thread that started the build does
+	LogSink* sink = Logger::GetThreadSink();
+	auto compileFile = [&](size_t i)
+	{
+		LogSink* previousSink = Logger::GetThreadSink();
+		Logger::SetThreadSink(sink);
+		Compilation compilation(options, inputs[i], reports[i], cache.get());
+		succeeded[i] = compilation.BuildModule(outputs[i]) && compilation.Emit(outputs[i], objects[i]);
+		if (!succeeded[i] && multiFile)
+			Logger::fmtLog(LogLevel::Error, "Compiling '%s' failed", inputs[i].c_str());
+		Logger::SetThreadSink(previousSink);
+	};
+
+	TimeReport build;
+	build.BeginPhase("compile");
+	unsigned jobs = options.jobs == 0 ? llvm::hardware_concurrency().compute_thread_count() : options.jobs;
+	if (!multiFile || (pool == nullptr && jobs <= 1))
+	{
+		for (size_t i = 0; i < inputs.size(); i++)
+			compileFile(i);
+	}
+	else
+	{
+		std::unique_ptr<llvm::ThreadPool> buildPool;
+		if (pool == nullptr)
+		{
+			llvm::ThreadPoolStrategy strategy = llvm::hardware_concurrency(jobs);
+			strategy.Limit = true;
+			buildPool = std::make_unique<llvm::ThreadPool>(strategy);
+			pool = buildPool.get();
+		}
+		// A shared pool runs other builds too, so only this build's tasks are waited for
+		std::vector<std::shared_future<void>> pending;
+		for (size_t i = 0; i < inputs.size(); i++)
+			pending.push_back(pool->async([&compileFile, i] { compileFile(i); }));
+		for (auto& task : pending)
+			task.wait();
+	}
+	build.EndPhase();
+	bool ok = std::all_of(succeeded.begin(), succeeded.end(), [](char fileSucceeded) { return fileSucceeded != 0; });
+
+	if (linking)
+	{
+		std::vector<std::string> objectFiles;
+		for (const auto& fileObjects : objects)
+			objectFiles.insert(objectFiles.end(), fileObjects.begin(), fileObjects.end());
+
+		// A single file keeps its link phase in its own report
+		TimeReport& linkReport = multiFile ? build : reports[0];
+		if (ok)
+		{
+			linkReport.BeginPhase("link");
+			ok = LinkExecutable(objectFiles, exeFile, options.linker);
+			linkReport.EndPhase();
+		}
+		for (const std::string& objectFile : objectFiles)
+		{
+			std::error_code removeError;
+			std::filesystem::remove(objectFile, removeError);
+		}
+	}
+
+	if (cache != nullptr)
+	{
+		cache->Prune();
+		if (options.cacheStats)
+			cache->PrintStats(reportOut);
+	}
+
+	if (!multiFile)
+		PrintReport(options, reports[0], reportOut);
+	else if (options.timeReport == ReportFormat::Text)
+		TimeReport::PrintBuildText(reportOut, inputs, reports, build);
+	else if (options.timeReport == ReportFormat::JSON)
+		TimeReport::PrintBuildJSON(reportOut, inputs, reports, build);
+	return ok ? 0 : -1;
+}
@@ -1,8 +1,24 @@
 #include "headers/Generate.h"
 
-Generator::Generator(std::unique_ptr<Program> program, const std::string& moduleName, const std::string& outPath)
-	: m_program(std::move(program)), m_outPath(outPath), m_moduleName(moduleName)
+#include <mutex>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/IntrinsicInst.h>
+
+Generator::Generator(const Program& program, StringInterner& interner, const std::string& moduleName, const std::string& outPath)
+	: m_outPath(outPath), m_moduleName(moduleName), m_program(program), m_interner(interner)
 {
+	m_mainSymbol = m_interner.Intern("main");
+	m_printfSymbol = m_interner.Intern("printf");
+	m_builtins[m_interner.Intern("len")] = Builtin::Length;
+	m_builtins[m_interner.Intern("shuffle")] = Builtin::Shuffle;
+	m_builtins[m_interner.Intern("reduceAdd")] = Builtin::ReduceAdd;
+	m_builtins[m_interner.Intern("reduceMul")] = Builtin::ReduceMul;
+	m_builtins[m_interner.Intern("reduceMin")] = Builtin::ReduceMin;
+	m_builtins[m_interner.Intern("reduceMax")] = Builtin::ReduceMax;
+	// Parsing is done, every identifier of the program already has its id
+	m_symbols.Reserve(m_interner.size());
+
 	// Always initialize context module and builder first
 	moduleInit();
 
@@ -36,30 +52,246 @@ Generator::Generator(std::unique_ptr<Program> program, const std::string& module
 	m_TypeMap[PrimitiveDataType::f32ptr] = llvm::Type::getFloatPtrTy(*ctx);
 	m_TypeMap[PrimitiveDataType::f64ptr] = llvm::Type::getDoublePtrTy(*ctx);
 
+	m_TypeMap[PrimitiveDataType::f32x4] = llvm::FixedVectorType::get(llvm::Type::getFloatTy(*ctx), 4);
+	m_TypeMap[PrimitiveDataType::f32x8] = llvm::FixedVectorType::get(llvm::Type::getFloatTy(*ctx), 8);
+	m_TypeMap[PrimitiveDataType::f64x2] = llvm::FixedVectorType::get(llvm::Type::getDoubleTy(*ctx), 2);
+	m_TypeMap[PrimitiveDataType::f64x4] = llvm::FixedVectorType::get(llvm::Type::getDoubleTy(*ctx), 4);
+	m_TypeMap[PrimitiveDataType::i32x4] = llvm::FixedVectorType::get(llvm::Type::getInt32Ty(*ctx), 4);
+	m_TypeMap[PrimitiveDataType::i32x8] = llvm::FixedVectorType::get(llvm::Type::getInt32Ty(*ctx), 8);
+	m_TypeMap[PrimitiveDataType::i64x2] = llvm::FixedVectorType::get(llvm::Type::getInt64Ty(*ctx), 2);
+	m_TypeMap[PrimitiveDataType::i64x4] = llvm::FixedVectorType::get(llvm::Type::getInt64Ty(*ctx), 4);
+
 }
 
-void Generator::Generate()
+bool Generator::Generate()
 {
-	for (auto& decl : m_program->DeclStmts)
+	for (auto& decl : m_program.DeclStmts)
 		if (CreateGlobalDecl(decl) == nullptr)
-			return;
+			return false;
+
+	// Functions of other shards are still declared in source order, so calls resolve exactly as unsharded
+	for (size_t i = 0; i < m_program.FnStmts.size(); i++)
+	{
+		bool define = m_definedFunctions.empty() || m_definedFunctions[i];
+		if (CreateFunction(m_program.FnStmts[i], define) == nullptr)
+			return false;
+	}
+
+	return true;
+}
+
+void Generator::SetShard(std::vector<bool> definedFunctions, bool definesGlobals)
+{
+	m_definedFunctions = std::move(definedFunctions);
+	m_definesGlobals = definesGlobals;
+}
+
+void Generator::SetConstEvalLimits(const ConstEvalLimits& limits)
+{
+	m_constEvalLimits = limits;
+	m_constEvaluator.reset();
+}
 
-	for (auto& fn : m_program->FnStmts)
-		if (CreateFunction(fn) == nullptr)
-			return;
+bool Generator::VerifyModule() const
+{
+	// Functions are checked one by one first so a failure names the function at fault.
+	// The verifier's findings go through the Logger so they reach whoever captures it
+	bool valid = true;
+	std::string problems;
+	llvm::raw_string_ostream problemStream(problems);
+	for (const llvm::Function& fn : *cModule)
+	{
+		// verifyFunction/verifyModule return true when the IR is broken
+		if (!fn.isDeclaration() && llvm::verifyFunction(fn, &problemStream))
+		{
+			problemStream.flush();
+			Logger::fmtLog(LogLevel::Error, "Function '%s' failed verification:\n%s", fn.getName().str().c_str(), llvm::StringRef(problems).rtrim().str().c_str());
+			problems.clear();
+			valid = false;
+		}
+	}
+	if (!valid)
+		return false;
 
-	cModule->print(llvm::outs(), nullptr);
+	if (llvm::verifyModule(*cModule, &problemStream))
+	{
+		problemStream.flush();
+		Logger::fmtLog(LogLevel::Error, "Generated module '%s' failed verification:\n%s", m_moduleName.c_str(), llvm::StringRef(problems).rtrim().str().c_str());
+		return false;
+	}
+	return true;
+}
 
-	// 3. Save m_module IR to file
-	saveModuleToFile();
+void Generator::InitializeTargets()
+{
+	// Registering every target is process wide and must only happen once
+	static std::once_flag targetsInitialized;
+	std::call_once(targetsInitialized, [] {
+		llvm::InitializeAllTargetInfos();
+		llvm::InitializeAllTargets();
+		llvm::InitializeAllTargetMCs();
+		llvm::InitializeAllAsmParsers();
+		llvm::InitializeAllAsmPrinters();
+	});
 }
 
-llvm::Value* Generator::CreateGlobalDecl(const std::unique_ptr<DeclStmt>& declStmt)
+bool Generator::InitTarget(const CompileOptions& options)
+{
+	InitializeTargets();
+
+	std::string tripleName = options.targetTriple.empty() ? llvm::sys::getDefaultTargetTriple() : options.targetTriple;
+	llvm::Triple triple(llvm::Triple::normalize(tripleName));
+
+	// With -march the architecture of the triple is replaced by the one asked for
+	std::string error;
+	const llvm::Target* target = llvm::TargetRegistry::lookupTarget(options.arch, triple, error);
+	if (target == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not find target '%s': %s", triple.str().c_str(), error.c_str());
+		return false;
+	}
+
+	std::string cpu = options.cpu.empty() ? "generic" : options.cpu;
+	llvm::SubtargetFeatures features;
+	if (cpu == "native")
+	{
+		cpu = llvm::sys::getHostCPUName().str();
+		llvm::StringMap<bool> hostFeatures;
+		if (llvm::sys::getHostCPUFeatures(hostFeatures))
+			for (auto& feature : hostFeatures)
+				features.AddFeature(feature.first(), feature.second);
+	}
+	// Explicit -mattr comes last so it overrides what the host reported
+	if (!options.features.empty())
+	{
+		llvm::SmallVector<llvm::StringRef, 16> explicitFeatures;
+		llvm::StringRef(options.features).split(explicitFeatures, ',', -1, false);
+		for (llvm::StringRef feature : explicitFeatures)
+			features.AddFeature(feature);
+	}
+
+	llvm::CodeGenOpt::Level codeGenLevel = llvm::CodeGenOpt::Default;
+	switch (options.optLevel)
+	{
+	case OptLevel::O0: codeGenLevel = llvm::CodeGenOpt::None; break;
+	case OptLevel::O1: codeGenLevel = llvm::CodeGenOpt::Less; break;
+	case OptLevel::O3: codeGenLevel = llvm::CodeGenOpt::Aggressive; break;
+	default: break;
+	}
+
+	llvm::TargetOptions targetOptions;
+	m_targetMachine.reset(target->createTargetMachine(triple.str(), cpu, features.getString(), targetOptions,
+		llvm::Reloc::PIC_, llvm::None, codeGenLevel));
+	if (m_targetMachine == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not create a target machine for '%s'", triple.str().c_str());
+		return false;
+	}
+
+	// The optimizer needs the layout to reason about sizes and alignment
+	cModule->setTargetTriple(triple.str());
+	cModule->setDataLayout(m_targetMachine->createDataLayout());
+	return true;
+}
+
+bool Generator::EmitMachineCode(const std::string& path, llvm::CodeGenFileType fileType)
+{
+	if (m_targetMachine == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "No target machine to emit '%s' with", path.c_str());
+		return false;
+	}
+
+	std::error_code errorCode;
+	llvm::raw_fd_ostream out(path, errorCode, llvm::sys::fs::OF_None);
+	if (errorCode)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not open '%s': %s", path.c_str(), errorCode.message().c_str());
+		return false;
+	}
+
+	// Instruction selection and the rest of the backend still run on the legacy pass manager
+	llvm::legacy::PassManager codeGenPasses;
+	if (m_targetMachine->addPassesToEmitFile(codeGenPasses, out, nullptr, fileType))
+	{
+		Logger::fmtLog(LogLevel::Error, "Target '%s' cannot emit this kind of file", m_targetMachine->getTargetTriple().str().c_str());
+		return false;
+	}
+
+	codeGenPasses.run(*cModule);
+	out.flush();
+	return true;
+}
+
+void Generator::OptimizeModule(OptLevel level, bool verifyEach)
+{
+	llvm::LoopAnalysisManager LAM;
+	llvm::FunctionAnalysisManager FAM;
+	llvm::CGSCCAnalysisManager CGAM;
+	llvm::ModuleAnalysisManager MAM;
+
+	llvm::PassInstrumentationCallbacks PIC;
+	llvm::StandardInstrumentations SI(false, verifyEach);
+	SI.registerCallbacks(PIC, &FAM);
+
+	// Like clang, loops are vectorized from -O2 and at -Os, straight-line code also at -Oz
+	llvm::PipelineTuningOptions tuning;
+	tuning.LoopVectorization = level == OptLevel::O2 || level == OptLevel::O3 || level == OptLevel::Os;
+	tuning.SLPVectorization = tuning.LoopVectorization || level == OptLevel::Oz;
+
+	// The target machine, when there is one, gives the cost model used by inlining and vectorization
+	llvm::PassBuilder PB(m_targetMachine.get(), tuning, llvm::None, &PIC);
+	PB.registerModuleAnalyses(MAM);
+	PB.registerCGSCCAnalyses(CGAM);
+	PB.registerFunctionAnalyses(FAM);
+	PB.registerLoopAnalyses(LAM);
+	PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+	llvm::ModulePassManager MPM;
+	switch (level)
+	{
+	case OptLevel::O0:
+		// Still runs the few passes -O0 needs, such as always-inline
+		MPM = PB.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+		break;
+	case OptLevel::O1:
+		MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1);
+		break;
+	case OptLevel::O2:
+		MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+		break;
+	case OptLevel::O3:
+		MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+		break;
+	case OptLevel::Os:
+		MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::Os);
+		break;
+	case OptLevel::Oz:
+		MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::Oz);
+		break;
+	}
+
+	MPM.run(*cModule, MAM);
+}
+
+void Generator::PrintModule(llvm::raw_ostream& out) const
+{
+	cModule->print(out, nullptr);
+}
+
+size_t Generator::getInstructionCount() const
+{
+	size_t count = 0;
+	for (const llvm::Function& fn : *cModule)
+		count += fn.getInstructionCount();
+	return count;
+}
+
+llvm::Value* Generator::CreateGlobalDecl(const DeclStmt* declStmt)
 {
 	llvm::Value* vAddr = nullptr;
 	llvm::Type* vType = nullptr;
 	llvm::Constant* initializer = nullptr;
-	llvm::Value* initialValue = GenerateExpr(declStmt->expr);
 
 	vType = findTypeFromPrimitive(declStmt->type);
 	if (vType == nullptr)
@@ -67,23 +299,109 @@ llvm::Value* Generator::CreateGlobalDecl(const std::unique_ptr<DeclStmt>& declSt
 		Logger::fmtLog(LogLevel::Error, "Unknown type found!");
 		return nullptr;
 	}
+	if (declStmt->arrayLength != 0)
+		vType = llvm::ArrayType::get(vType, declStmt->arrayLength);
+
+	if (m_symbols.isDeclaredInScope(declStmt->IDENT))
+	{
+		Logger::fmtLog(LogLevel::Error, "Global '%s' has been declared twice", getName(declStmt->IDENT).data());
+		return nullptr;
+	}
+
+	// A const is only a name for its value, every shard evaluates it and nothing is emitted
+	if (declStmt->isConst)
+	{
+		// All shards fail on the same const, only the one defining the globals reports why
+		LogSink discarded;
+		LogSink* sink = Logger::GetThreadSink();
+		if (!m_definesGlobals)
+			Logger::SetThreadSink(&discarded);
+		llvm::Constant* constant = EvaluateConstant(declStmt);
+		Logger::SetThreadSink(sink);
+		if (constant == nullptr)
+			return nullptr;
+		varInfo info = { nullptr, vType, 0, constant, nullptr, false, isUnsignedType(declStmt->type) };
+		m_symbols.Declare(declStmt->IDENT, info);
+		m_globalConstants[declStmt->IDENT] = info;
+		return constant;
+	}
 
-	initializer = llvm::ConstantInt::get(vType, llvm::dyn_cast<llvm::ConstantInt>(initialValue)->getSExtValue());
+	// Another shard defines it. Globals are created by the module like functions and blocks are by their Create,
+	// a new-expression here pairs User's operator new with a plain delete, which GCC flags (-Wmismatched-new-delete)
+	if (!m_definesGlobals)
+	{
+		auto* declaration = llvm::cast<llvm::GlobalVariable>(cModule->getOrInsertGlobal(getName(declStmt->IDENT), vType));
+		if (vType->isArrayTy())
+			declaration->setAlignment(getArrayAlignment(vType));
+		m_symbols.Declare(declStmt->IDENT, { declaration, vType, 0, nullptr, nullptr, false, isUnsignedType(declStmt->type) });
+		return declaration;
+	}
 
-	vAddr = new llvm::GlobalVariable(*cModule,
-		vType,
-		false,
-		llvm::GlobalValue::ExternalLinkage,
-		initializer,
-		declStmt->IDENT
-	);
+	if (declStmt->expr == nullptr)
+		initializer = llvm::Constant::getNullValue(vType);
+	else
+	{
+		// Folding has already reduced initializers of only literals to a single one, those naming consts
+		// or calling const fns are left to the evaluator
+		const Expr* expr = declStmt->expr;
+		if (expr->nodes.size() == 1 && expr->root().kind == ExprKind::Literal)
+		{
+			if (llvm::Value* literal = GenerateLiteral(expr->root().literal))
+				if (llvm::Value* value = autoTypeCast(literal, vType, isUnsignedLiteral(expr->root().literal), isUnsignedType(declStmt->type)))
+					initializer = llvm::dyn_cast<llvm::Constant>(value);
+		}
+		else
+			initializer = EvaluateConstant(declStmt);
+		if (initializer == nullptr)
+		{
+			Logger::fmtLog(LogLevel::Error, "Initializer of global '%s' is not a constant", getName(declStmt->IDENT).data());
+			return nullptr;
+		}
+	}
+
+	// An external, non constant global like the declaration above
+	auto* global = llvm::cast<llvm::GlobalVariable>(cModule->getOrInsertGlobal(getName(declStmt->IDENT), vType));
+	global->setInitializer(initializer);
+	if (vType->isArrayTy())
+		global->setAlignment(getArrayAlignment(vType));
+	vAddr = global;
+	m_symbols.Declare(declStmt->IDENT, { vAddr, vType, 0, nullptr, nullptr, false, isUnsignedType(declStmt->type) });
 
 	return vAddr;
 }
 
-llvm::Function* Generator::CreateFunction(const std::unique_ptr<FnStmt>& fnStmt)
+llvm::Constant* Generator::EvaluateConstant(const DeclStmt* declStmt)
+{
+	if (m_constEvaluator == nullptr)
+		m_constEvaluator = std::make_unique<ConstEvaluator>(m_program, m_interner, m_constEvalLimits);
+
+	auto resolve = [this](SymbolID id, bool globalOnly, ConstValue& value)
+	{
+		const varInfo* vInfo = nullptr;
+		if (!globalOnly)
+			vInfo = m_symbols.Lookup(id);
+		else if (auto it = m_globalConstants.find(id); it != m_globalConstants.end())
+			vInfo = &it->second;
+		if (vInfo == nullptr || vInfo->constant == nullptr || !ConstEvaluator::fromConstant(vInfo->constant, value))
+			return false;
+		value.isUnsigned = vInfo->isUnsigned;
+		return true;
+	};
+
+	ConstValue value;
+	if (!m_constEvaluator->Evaluate(declStmt->expr, declStmt->type, resolve, value))
+	{
+		Logger::fmtLog(LogLevel::Error, "Value of '%s' could not be computed", getName(declStmt->IDENT).data());
+		return nullptr;
+	}
+	// Already converted to the declared type, an u32 comes back as the i32 LLVM uses for it
+	return ConstEvaluator::toConstant(value, *ctx);
+}
+
+llvm::Function* Generator::CreateFunction(const FnStmt* fnStmt, bool define)
 {
-	auto fn = cModule->getFunction(fnStmt->name);
+	fnInfo& info = m_FunctionMap[fnStmt->name];
+	llvm::Function* fn = info.fn;
 
 	llvm::FunctionType* fnType = nullptr;
 
@@ -96,6 +414,17 @@ llvm::Function* Generator::CreateFunction(const std::unique_ptr<FnStmt>& fnStmt)
 	{
 		if (param->VarArg)
 			isVarArgs = true;
+		else if (param->isSlice)
+		{
+			llvm::Type* elementType = findTypeFromPrimitive(param->type);
+			if (elementType == nullptr || elementType->isVoidTy())
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid element type of slice '%s'", getName(param->ident).data());
+				return nullptr;
+			}
+			paramsList.push_back(elementType->getPointerTo());
+			paramsList.push_back(llvm::Type::getInt64Ty(*ctx));
+		}
 		else
 			paramsList.push_back(m_TypeMap[param->type]);
 	}
@@ -107,209 +436,1052 @@ llvm::Function* Generator::CreateFunction(const std::unique_ptr<FnStmt>& fnStmt)
 		return nullptr;
 	}
 
-	fnType = llvm::FunctionType::get(retType, paramsList, true);
+	// Only a declared `...` makes the function variadic, a variadic function is never inlined
+	fnType = llvm::FunctionType::get(retType, paramsList, isVarArgs);
 
 	if (fn == nullptr)
 	{
 		// No function exists/declared
-		if (fnStmt->isExtern || fnStmt->name == "main")
-			fn = llvm::Function::Create(fnType, llvm::GlobalValue::ExternalLinkage, fnStmt->name, *cModule);
+		if (fnStmt->isExtern || fnStmt->name == m_mainSymbol)
+			fn = llvm::Function::Create(fnType, llvm::GlobalValue::ExternalLinkage, getName(fnStmt->name), *cModule);
+		else if (!m_definedFunctions.empty())
+		{
+			// Shards call each other, hidden keeps the symbol out of the linked executable's exports
+			fn = llvm::Function::Create(fnType, llvm::GlobalValue::ExternalLinkage, getName(fnStmt->name), *cModule);
+			fn->setVisibility(llvm::GlobalValue::HiddenVisibility);
+		}
 		else
-			fn = llvm::Function::Create(fnType, llvm::GlobalValue::InternalLinkage, fnStmt->name, *cModule);
+			fn = llvm::Function::Create(fnType, llvm::GlobalValue::InternalLinkage, getName(fnStmt->name), *cModule);
+		AddFunctionAttributes(fn, fnStmt);
 		llvm::verifyFunction(*fn);
+
+		info.fn = fn;
+		info.fnType = fnType;
+		info.fnStmt = fnStmt;
 	}
 
 	// If there is no compound statement then just return the current
-	if (fnStmt->compoundStmt.get() == NULL)
+	if (fnStmt->compoundStmt == nullptr || !define)
 		return fn;
 	
+	info.isDefined = true;
+
 	// Create function block
 	auto entry = llvm::BasicBlock::Create(*ctx, "entry", fn);
 	builder->SetInsertPoint(entry);
 	m_FunctionType = fn->getFunctionType();
+	m_returnsUnsigned = isUnsignedType(fnStmt->returnType);
+	// Nothing branches to the entry
+	m_ssa.Reset();
+	m_ssa.SealBlock(entry);
+
+	// The parameters and the outermost block of the body share a scope, like in C
+	m_symbols.PushScope();
+	bool generated = true;
+	unsigned argIndex = 0;
+	for (const ParamDecl* param : fnStmt->params)
+	{
+		if (param->VarArg)
+			continue;
+
+		bool declared = false;
+		if (param->isSlice)
+		{
+			// Slices cannot be assigned, their pointer and length are used as they are
+			llvm::Argument* data = fn->getArg(argIndex++);
+			llvm::Argument* length = fn->getArg(argIndex++);
+			data->setName(getName(param->ident));
+			length->setName(getName(param->ident) + ".len");
+			declared = m_symbols.Declare(param->ident, { data, m_TypeMap[param->type], 0, nullptr, length, false, isUnsignedType(param->type) });
+		}
+		else
+		{
+			// Parameters are variables like any other, their first value is the argument
+			llvm::Argument* arg = fn->getArg(argIndex++);
+			arg->setName(getName(param->ident));
+			SSABuilder::Variable var = m_ssa.NewVariable(arg->getType(), getName(param->ident));
+			m_ssa.WriteVariable(var, entry, arg);
+			declared = m_symbols.Declare(param->ident, { nullptr, arg->getType(), var, nullptr, nullptr, false, isUnsignedType(param->type) });
+		}
+		if (!declared)
+		{
+			Logger::fmtLog(LogLevel::Error, "Parameter '%s' of '%s' has been declared twice", getName(param->ident).data(), getName(fnStmt->name).data());
+			generated = false;
+			break;
+		}
+	}
 
 	// Generate Compound Statement
-	GenerateCompoundStatement(fnStmt->compoundStmt);
+	generated = generated && GenerateCompoundStatement(fnStmt->compoundStmt);
+	m_symbols.PopScope();
+
+	llvm::BasicBlock* last = builder->GetInsertBlock();
+	if (generated && last->getTerminator() == nullptr)
+	{
+		if (retType->isVoidTy())
+			builder->CreateRetVoid();
+		else if (last != entry && llvm::pred_empty(last))
+			builder->CreateUnreachable();
+		else
+		{
+			Logger::fmtLog(LogLevel::Error, "Function '%s' can reach its end without returning a value", getName(fnStmt->name).data());
+			generated = false;
+		}
+	}
+
+	if (generated && (fnStmt->attributes & FN_PURE))
+		generated = CheckPureFunction(fn, fnStmt);
 
 	m_FunctionType = nullptr;
-	return fn;
+	m_returnsUnsigned = false;
+	return generated ? fn : nullptr;
 }
 
-llvm::CallInst* Generator::CreateFunctionCall(const std::unique_ptr<FnCall>& FunctionCall)
+void Generator::AddFunctionAttributes(llvm::Function* fn, const FnStmt* fnStmt)
 {
-	std::vector<llvm::Value*> ArgsV;
+	// Veritas has no exceptions, only functions written in another language could unwind
+	if (fnStmt->compoundStmt != nullptr)
+		fn->addFnAttr(llvm::Attribute::NoUnwind);
 
-	for (auto& argExpr : FunctionCall->args->list)
-		ArgsV.push_back(GenerateExpr(argExpr));
+	if (fnStmt->attributes & FN_INLINE)
+		fn->addFnAttr(llvm::Attribute::AlwaysInline);
+	if (fnStmt->attributes & FN_NOINLINE)
+		fn->addFnAttr(llvm::Attribute::NoInline);
+	if (fnStmt->attributes & FN_COLD)
+	{
+		// Like clang, cold code is also kept small
+		fn->addFnAttr(llvm::Attribute::Cold);
+		fn->addFnAttr(llvm::Attribute::OptimizeForSize);
+	}
+	if (fnStmt->attributes & FN_HOT)
+		fn->addFnAttr(llvm::Attribute::Hot);
+	if (fnStmt->attributes & FN_PURE)
+	{
+		// Enough to hoist and merge calls and drop unused ones. CheckPureFunction tightens it to readnone
+		// where the body is generated, other shards and extern declarations keep readonly
+		fn->addFnAttr(llvm::Attribute::ReadOnly);
+		fn->addFnAttr(llvm::Attribute::WillReturn);
+		fn->addFnAttr(llvm::Attribute::NoUnwind);
+	}
 
-	int count = 0;
-	if (FunctionCall->name == "printf")
+	// Slices are only made from arrays, which have at least one element. Functions C can call might get any pointer
+	bool calledFromVeritas = !fnStmt->isExtern && fnStmt->name != m_mainSymbol;
+	const llvm::DataLayout& layout = cModule->getDataLayout();
+	unsigned argNo = 0;
+	for (const ParamDecl* param : fnStmt->params)
 	{
-		// Convert all Argv of type f32 to f64, reason: Only God knows why, but only that way "%f" works
-		for (auto& argv : ArgsV)
-			if (argv->getType()->isFloatTy())
-				argv = builder->CreateFPExt(argv, llvm::Type::getDoubleTy(*ctx), "ftod" + std::to_string(count));
+		if (param->VarArg)
+			continue;
+		if (param->isRestrict)
+			fn->addParamAttr(argNo, llvm::Attribute::NoAlias);
+		if (param->alignment != 0)
+			fn->addParamAttr(argNo, llvm::Attribute::getWithAlignment(*ctx, llvm::Align(param->alignment)));
+		if (param->isSlice && calledFromVeritas)
+		{
+			llvm::Type* elementType = fn->getArg(argNo)->getType()->getPointerElementType();
+			fn->addParamAttr(argNo, llvm::Attribute::NonNull);
+			fn->addDereferenceableParamAttr(argNo, layout.getTypeAllocSize(elementType).getFixedSize());
+		}
+		argNo += param->isSlice ? 2 : 1;
 	}
+}
 
-	llvm::Function* calledFn = cModule->getFunction(FunctionCall->name);
-	llvm::CallInst* Call = builder->CreateCall(calledFn, ArgsV, FunctionCall->name + "calltmp");
+bool Generator::CheckPureFunction(llvm::Function* fn, const FnStmt* fnStmt)
+{
+	// Locals are SSA values or allocas, anything else a pure function touches is memory of its caller
+	auto isLocal = [](const llvm::Value* address) { return llvm::isa<llvm::AllocaInst>(llvm::getUnderlyingObject(address)); };
+
+	bool readsMemory = false;
+	for (llvm::BasicBlock& block : *fn)
+	{
+		for (llvm::Instruction& inst : block)
+		{
+			if (auto* load = llvm::dyn_cast<llvm::LoadInst>(&inst))
+				readsMemory = readsMemory || !isLocal(load->getPointerOperand());
+			else if (auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst))
+			{
+				if (!isLocal(store->getPointerOperand()))
+				{
+					Logger::fmtLog(LogLevel::Error, "Pure function '%s' writes memory that is not its own", getName(fnStmt->name).data());
+					return false;
+				}
+			}
+			else if (auto* memset = llvm::dyn_cast<llvm::MemSetInst>(&inst))
+			{
+				// Zeroing a local array
+				if (!isLocal(memset->getDest()))
+				{
+					Logger::fmtLog(LogLevel::Error, "Pure function '%s' writes memory that is not its own", getName(fnStmt->name).data());
+					return false;
+				}
+			}
+			else if (auto* call = llvm::dyn_cast<llvm::CallInst>(&inst))
+			{
+				llvm::Function* callee = call->getCalledFunction();
+				if (callee != nullptr && callee->doesNotAccessMemory())
+					continue;
+				if (callee == nullptr || !callee->onlyReadsMemory() || !callee->willReturn())
+				{
+					Logger::fmtLog(LogLevel::Error, "Pure function '%s' calls '%s', which is not pure", getName(fnStmt->name).data(),
+						callee != nullptr ? callee->getName().str().c_str() : "?");
+					return false;
+				}
+				readsMemory = true;
+			}
+		}
+	}
+
+	if (!readsMemory)
+	{
+		fn->removeFnAttr(llvm::Attribute::ReadOnly);
+		fn->addFnAttr(llvm::Attribute::ReadNone);
+	}
+	return true;
+}
+
+llvm::CallInst* Generator::CreateFunctionCall(const FnCall* FunctionCall)
+{
+	auto it = m_FunctionMap.find(FunctionCall->name);
+	if (it == m_FunctionMap.end() || it->second.fn == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "Call to undeclared function '%s'", getName(FunctionCall->name).data());
+		return nullptr;
+	}
+	const FnStmt* fnStmt = it->second.fnStmt;
+	llvm::FunctionType* fnType = it->second.fnType;
+
+	size_t fixedParams = 0;
+	for (const ParamDecl* param : fnStmt->params)
+		if (!param->VarArg)
+			fixedParams++;
+
+	// Calls without arguments have no args list
+	size_t argCount = FunctionCall->args != nullptr ? FunctionCall->args->list.size() : 0;
+	if (argCount < fixedParams || (argCount > fixedParams && !fnType->isVarArg()))
+	{
+		Logger::fmtLog(LogLevel::Error, "'%s' takes %zu arguments, %zu given", getName(FunctionCall->name).data(), fixedParams, argCount);
+		return nullptr;
+	}
+
+	std::vector<llvm::Value*> ArgsV;
+	// Arrays and slices passed so far and whether their parameter is restrict
+	llvm::SmallVector<std::pair<llvm::Value*, bool>, 4> passedSlices;
+	for (size_t i = 0; i < argCount; i++)
+	{
+		const Expr* argExpr = FunctionCall->args->list[i];
+		const ParamDecl* param = i < fixedParams ? fnStmt->params[i] : nullptr;
+
+		if (param != nullptr && param->isSlice)
+		{
+			// An array or slice is passed by name, as the pointer to its first element and its length
+			const varInfo* vInfo = nullptr;
+			if (argExpr->nodes.size() == 1 && argExpr->root().kind == ExprKind::Ident)
+				vInfo = m_symbols.Lookup(argExpr->root().name);
+			llvm::Type* paramType = fnType->getParamType(ArgsV.size())->getPointerElementType();
+			if (vInfo != nullptr)
+			{
+				// The one case restrict can be checked: the same array or slice passed twice, to a restrict parameter
+				for (const auto& other : passedSlices)
+				{
+					if (other.first == vInfo->vAddr && (other.second || param->isRestrict))
+					{
+						Logger::fmtLog(LogLevel::Error, "'%s' is passed to '%s' twice, argument %zu or the other is restrict",
+							getName(argExpr->root().name).data(), getName(FunctionCall->name).data(), i + 1);
+						return nullptr;
+					}
+				}
+				passedSlices.emplace_back(vInfo->vAddr, param->isRestrict);
+			}
+			if (vInfo != nullptr && param->alignment != 0 && !CheckAlignment(vInfo, argExpr->root().name, param->alignment))
+				return nullptr;
+			if (vInfo != nullptr && vInfo->vType->isArrayTy() && vInfo->vType->getArrayElementType() == paramType)
+			{
+				ArgsV.push_back(builder->CreateConstInBoundsGEP2_64(vInfo->vType, vInfo->vAddr, 0, 0));
+				ArgsV.push_back(builder->getInt64(vInfo->vType->getArrayNumElements()));
+			}
+			else if (vInfo != nullptr && vInfo->length != nullptr && vInfo->vType == paramType)
+			{
+				ArgsV.push_back(vInfo->vAddr);
+				ArgsV.push_back(vInfo->length);
+			}
+			else
+			{
+				Logger::fmtLog(LogLevel::Error, "Argument %zu of '%s' has to name an array or slice of its element type",
+					i + 1, getName(FunctionCall->name).data());
+				return nullptr;
+			}
+			continue;
+		}
+
+		bool argUnsigned = false;
+		llvm::Value* arg = GenerateExpr(argExpr, &argUnsigned);
+		if (arg == nullptr)
+			return nullptr;
+		if (param != nullptr)
+		{
+			arg = autoTypeCast(arg, fnType->getParamType(ArgsV.size()), argUnsigned, isUnsignedType(param->type));
+			if (arg == nullptr)
+				return nullptr;
+		}
+		else if (arg->getType()->isVectorTy())
+		{
+			Logger::fmtLog(LogLevel::Error, "Argument %zu of '%s' is a vector, variadic arguments take its lanes one by one",
+				i + 1, getName(FunctionCall->name).data());
+			return nullptr;
+		}
+		else if (FunctionCall->name == m_printfSymbol && arg->getType()->isFloatTy())
+		{
+			// Convert all Argv of type f32 to f64, reason: Only God knows why, but only that way "%f" works
+			arg = builder->CreateFPExt(arg, llvm::Type::getDoubleTy(*ctx), "ftod");
+		}
+		ArgsV.push_back(arg);
+	}
+
+	llvm::Function* calledFn = it->second.fn;
+	llvm::CallInst* Call = builder->CreateCall(calledFn, ArgsV, calledFn->getReturnType()->isVoidTy() ? "" : getName(FunctionCall->name) + "calltmp");
 	return Call;
 }
 
-void Generator::GenerateCompoundStatement(const std::unique_ptr<CompoundStmt>& cmpndStmt)
+const Builtin* Generator::findBuiltin(SymbolID name) const
+{
+	auto it = m_builtins.find(name);
+	if (it == m_builtins.end() || m_FunctionMap.count(name) != 0)
+		return nullptr;
+	return &it->second;
+}
+
+llvm::Value* Generator::GenerateBuiltinCall(const FnCall* call, Builtin builtin)
+{
+	switch (builtin)
+	{
+	case Builtin::Length:
+		return GenerateLength(call);
+	case Builtin::Shuffle:
+		return GenerateShuffle(call);
+	default:
+		return GenerateReduction(call, builtin);
+	}
+}
+
+llvm::Align Generator::getArrayAlignment(llvm::Type* arrayType) const
+{
+	// Arrays of a cache line or more start on one, so align(N) parameters up to 64 take any of them
+	const llvm::DataLayout& layout = cModule->getDataLayout();
+	llvm::Align alignment = layout.getABITypeAlign(arrayType);
+	if (layout.getTypeAllocSize(arrayType).getFixedSize() >= 64)
+		alignment = std::max(alignment, llvm::Align(64));
+	return alignment;
+}
+
+bool Generator::CheckAlignment(const varInfo* vInfo, SymbolID name, uint32_t alignment)
+{
+	llvm::Align required(alignment);
+	// A local array is simply allocated with the larger alignment
+	if (auto* alloca = llvm::dyn_cast<llvm::AllocaInst>(vInfo->vAddr))
+	{
+		if (alloca->getAlign() < required)
+			alloca->setAlignment(required);
+		return true;
+	}
+	// Globals are declared by every shard, their alignment cannot depend on the calls one of them sees
+	if (auto* global = llvm::dyn_cast<llvm::GlobalVariable>(vInfo->vAddr))
+	{
+		if (global->getAlign().valueOrOne() >= required)
+			return true;
+		Logger::fmtLog(LogLevel::Error, "Global array '%s' is aligned to %llu bytes, the parameter requires align(%u)",
+			getName(name).data(), (unsigned long long)global->getAlign().valueOrOne().value(), alignment);
+		return false;
+	}
+	// A slice parameter, aligned as much as its own align(N) says
+	auto* argument = llvm::dyn_cast<llvm::Argument>(vInfo->vAddr);
+	if (argument != nullptr && argument->getParamAlign().valueOrOne() >= required)
+		return true;
+	Logger::fmtLog(LogLevel::Error, "Slice '%s' is not known to be aligned to %u bytes, declare it align(%u)", getName(name).data(), alignment, alignment);
+	return false;
+}
+
+llvm::Value* Generator::GenerateLength(const FnCall* call)
+{
+	const Expr* arg = call->args != nullptr && call->args->list.size() == 1 ? call->args->list[0] : nullptr;
+	const varInfo* vInfo = nullptr;
+	if (arg != nullptr && arg->nodes.size() == 1 && arg->root().kind == ExprKind::Ident)
+		vInfo = m_symbols.Lookup(arg->root().name);
+
+	if (vInfo != nullptr && vInfo->vType->isArrayTy())
+		return builder->getInt64(vInfo->vType->getArrayNumElements());
+	if (vInfo != nullptr && vInfo->length != nullptr)
+		return vInfo->length;
+	Logger::fmtLog(LogLevel::Error, "len takes the name of an array or slice");
+	return nullptr;
+}
+
+llvm::Value* Generator::GenerateShuffle(const FnCall* call)
+{
+	size_t argCount = call->args != nullptr ? call->args->list.size() : 0;
+	llvm::SmallVector<llvm::Value*, 16> args;
+	for (size_t i = 0; i < argCount; i++)
+	{
+		llvm::Value* arg = GenerateExpr(call->args->list[i]);
+		if (arg == nullptr)
+			return nullptr;
+		args.push_back(arg);
+	}
+
+	auto* vectorType = args.empty() ? nullptr : llvm::dyn_cast<llvm::FixedVectorType>(args[0]->getType());
+	if (vectorType == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "shuffle takes a vector, optionally a second of the same type, then the lanes to pick");
+		return nullptr;
+	}
+	llvm::Value* first = args[0];
+	llvm::Value* second = llvm::PoisonValue::get(vectorType);
+	size_t firstLane = 1;
+	if (args.size() > 1 && args[1]->getType()->isVectorTy())
+	{
+		if (args[1]->getType() != vectorType)
+		{
+			Logger::fmtLog(LogLevel::Error, "Both vectors of a shuffle need the same type");
+			return nullptr;
+		}
+		second = args[1];
+		firstLane = 2;
+	}
+
+	// shufflevector takes a constant mask, so every lane has to be known while compiling
+	uint64_t laneCount = vectorType->getNumElements() * (firstLane == 2 ? 2 : 1);
+	llvm::SmallVector<int, 16> mask;
+	for (size_t i = firstLane; i < args.size(); i++)
+	{
+		auto* lane = llvm::dyn_cast<llvm::ConstantInt>(args[i]);
+		if (lane == nullptr || lane->getValue().getActiveBits() > 32 || lane->getZExtValue() >= laneCount)
+		{
+			Logger::fmtLog(LogLevel::Error, "Lane %zu of a shuffle has to be a constant below %llu", i - firstLane + 1, (unsigned long long)laneCount);
+			return nullptr;
+		}
+		mask.push_back((int)lane->getZExtValue());
+	}
+	if (mask.empty())
+	{
+		Logger::fmtLog(LogLevel::Error, "shuffle picks no lanes");
+		return nullptr;
+	}
+	return builder->CreateShuffleVector(first, second, mask, "shuffle");
+}
+
+llvm::Value* Generator::GenerateReduction(const FnCall* call, Builtin builtin)
+{
+	if (call->args == nullptr || call->args->list.size() != 1)
+	{
+		Logger::fmtLog(LogLevel::Error, "%s takes a single vector", getName(call->name).data());
+		return nullptr;
+	}
+	llvm::Value* vector = GenerateExpr(call->args->list[0]);
+	if (vector == nullptr)
+		return nullptr;
+	if (!vector->getType()->isVectorTy())
+	{
+		Logger::fmtLog(LogLevel::Error, "%s takes a single vector", getName(call->name).data());
+		return nullptr;
+	}
+
+	// Integer lanes are signed like every other integer operation
+	llvm::Type* elementType = vector->getType()->getScalarType();
+	if (elementType->isIntegerTy())
+	{
+		switch (builtin)
+		{
+		case Builtin::ReduceAdd:	return builder->CreateAddReduce(vector);
+		case Builtin::ReduceMul:	return builder->CreateMulReduce(vector);
+		case Builtin::ReduceMin:	return builder->CreateIntMinReduce(vector, true);
+		default:					return builder->CreateIntMaxReduce(vector, true);
+		}
+	}
+
+	llvm::CallInst* reduction = nullptr;
+	switch (builtin)
+	{
+	case Builtin::ReduceAdd:
+		reduction = builder->CreateFAddReduce(llvm::ConstantFP::getNegativeZero(elementType), vector);
+		break;
+	case Builtin::ReduceMul:
+		reduction = builder->CreateFMulReduce(llvm::ConstantFP::get(elementType, 1.0), vector);
+		break;
+	case Builtin::ReduceMin:
+		return builder->CreateFPMinReduce(vector);
+	default:
+		return builder->CreateFPMaxReduce(vector);
+	}
+	// Without reassoc the lanes are added strictly in order, a chain of scalar adds instead of a shuffle tree
+	llvm::FastMathFlags flags;
+	flags.setAllowReassoc();
+	reduction->setFastMathFlags(flags);
+	return reduction;
+}
+
+bool Generator::GenerateCompoundStatement(const CompoundStmt* cmpndStmt)
 {
 	for (auto& s : cmpndStmt->statementList)
-		GenerateStatement(s);
+	{
+		// Statements after a return are still generated, into a block nothing branches to
+		if (builder->GetInsertBlock()->getTerminator() != nullptr)
+		{
+			llvm::BasicBlock* dead = llvm::BasicBlock::Create(*ctx, "dead", builder->GetInsertBlock()->getParent());
+			m_ssa.SealBlock(dead);
+			builder->SetInsertPoint(dead);
+		}
+		if (!GenerateStatement(s))
+			return false;
+	}
+	return true;
 }
 
-void Generator::GenerateStatement(const std::unique_ptr<Stmt>& stmt)
+bool Generator::GenerateStatement(const Stmt* stmt)
 {
 	struct stmtVisitor
 	{
-		void operator()(const std::unique_ptr<DeclStmt>& declStmt)
+		bool operator()(const DeclStmt* declStmt)
 		{
-			if (gen.m_symbolMap.count(declStmt->IDENT) == 1)
+			if (gen.m_symbols.isDeclaredInScope(declStmt->IDENT))
 			{
-				Logger::fmtLog(LogLevel::Error, "Identifier '%s' has been declared twice", declStmt->IDENT);
-				return;
+				Logger::fmtLog(LogLevel::Error, "Identifier '%s' has been declared twice", gen.getName(declStmt->IDENT).data());
+				return false;
 			}
 
-			llvm::Value* initialValue = nullptr;
-			if (declStmt->expr.get() != NULL)
-				initialValue = gen.GenerateExpr(declStmt->expr);
-
 			llvm::Type* _type = nullptr;
 			_type = gen.findTypeFromPrimitive(declStmt->type);
 
 			if (_type == nullptr)
 			{
 				Logger::fmtLog(LogLevel::Error, "Invalid type found of variable!");
-				return;
+				return false;
+			}
+
+			if (declStmt->isConst)
+			{
+				llvm::Constant* constant = gen.EvaluateConstant(declStmt);
+				if (constant == nullptr)
+					return false;
+				gen.m_symbols.Declare(declStmt->IDENT, { nullptr, _type, 0, constant, nullptr, false, isUnsignedType(declStmt->type) });
+				return true;
+			}
+
+			if (declStmt->arrayLength != 0)
+			{
+				// Arrays live in memory, allocated in the entry block so a loop does not grow the stack
+				llvm::Type* arrayType = llvm::ArrayType::get(_type, declStmt->arrayLength);
+				llvm::BasicBlock& entry = gen.builder->GetInsertBlock()->getParent()->getEntryBlock();
+				llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+				llvm::AllocaInst* array = entryBuilder.CreateAlloca(arrayType, nullptr, gen.getName(declStmt->IDENT));
+				array->setAlignment(gen.getArrayAlignment(arrayType));
+				// Zeroed every time the declaration is reached
+				uint64_t size = gen.cModule->getDataLayout().getTypeAllocSize(arrayType).getFixedSize();
+				gen.builder->CreateMemSet(array, gen.builder->getInt8(0), size, array->getAlign());
+				gen.m_symbols.Declare(declStmt->IDENT, { array, arrayType, 0, nullptr, nullptr, false, isUnsignedType(declStmt->type) });
+				return true;
+			}
+
+			// Generated before the variable is declared, so a shadowing `let x = x` reads the outer x
+			llvm::Value* initialValue = nullptr;
+			bool valueUnsigned = false;
+			if (declStmt->expr != nullptr)
+			{
+				initialValue = gen.GenerateExpr(declStmt->expr, &valueUnsigned);
+				if (initialValue == nullptr)
+					return false;
 			}
 
-			// Create the variable on stack
-			auto vAddr = gen.builder->CreateAlloca(_type, nullptr, declStmt->IDENT);
-			gen.m_symbolMap[declStmt->IDENT] = { vAddr, _type };
+			// Locals are never address taken, so they live in SSA values instead of stack slots
+			if (initialValue == nullptr)
+				initialValue = llvm::Constant::getNullValue(_type);
+			initialValue = gen.autoTypeCast(initialValue, _type, valueUnsigned, isUnsignedType(declStmt->type));
+			if (initialValue == nullptr)
+				return false;
+			SSABuilder::Variable var = gen.m_ssa.NewVariable(_type, gen.getName(declStmt->IDENT));
+			gen.m_ssa.WriteVariable(var, gen.builder->GetInsertBlock(), initialValue);
+			gen.m_symbols.Declare(declStmt->IDENT, { nullptr, _type, var, nullptr, nullptr, false, isUnsignedType(declStmt->type) });
+			return true;
+		}
+		bool operator()(const AssignStmt* assignStmt)
+		{
+			const varInfo* vInfo = gen.m_symbols.Lookup(assignStmt->ident);
+			if (vInfo == nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Assignment to undeclared identifier '%s'", gen.getName(assignStmt->ident).data());
+				return false;
+			}
+			if (vInfo->constant != nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Cannot assign to const '%s'", gen.getName(assignStmt->ident).data());
+				return false;
+			}
+			if (vInfo->isLoopVariable)
+			{
+				Logger::fmtLog(LogLevel::Error, "Cannot assign to the loop variable '%s'", gen.getName(assignStmt->ident).data());
+				return false;
+			}
 
-			// Initialize the variable with the initial value
-			initialValue = gen.autoTypeCast(initialValue, _type);
-			gen.builder->CreateStore(initialValue, vAddr);
+			if (assignStmt->index != nullptr && vInfo->vType->isVectorTy() && vInfo->length == nullptr)
+			{
+				// A lane is replaced by writing the whole vector back
+				bool indexUnsigned = false;
+				llvm::Value* index = gen.GenerateExpr(assignStmt->index, &indexUnsigned);
+				if (index == nullptr)
+					return false;
+				auto* vectorType = llvm::cast<llvm::FixedVectorType>(vInfo->vType);
+				index = gen.GenerateLaneIndex(vectorType, index, indexUnsigned);
+				if (index == nullptr)
+					return false;
+				bool valueUnsigned = false;
+				llvm::Value* value = gen.GenerateExpr(assignStmt->value, &valueUnsigned);
+				if (value == nullptr)
+					return false;
+				value = gen.autoTypeCast(value, vectorType->getElementType(), valueUnsigned);
+				if (value == nullptr)
+					return false;
+				llvm::Value* vector = gen.ReadVariable(vInfo, assignStmt->ident);
+				vector = gen.builder->CreateInsertElement(vector, value, index, gen.getName(assignStmt->ident) + "ins");
+				if (vInfo->vAddr != nullptr)
+					gen.builder->CreateStore(vector, vInfo->vAddr);
+				else
+					gen.m_ssa.WriteVariable(vInfo->ssaVariable, gen.builder->GetInsertBlock(), vector);
+				return true;
+			}
+			if (assignStmt->index != nullptr)
+			{
+				bool indexUnsigned = false;
+				llvm::Value* index = gen.GenerateExpr(assignStmt->index, &indexUnsigned);
+				if (index == nullptr)
+					return false;
+				llvm::Type* elementType = nullptr;
+				llvm::Value* address = gen.GenerateElementAddress(assignStmt->ident, index, indexUnsigned, elementType);
+				if (address == nullptr)
+					return false;
+				bool valueUnsigned = false;
+				llvm::Value* value = gen.GenerateExpr(assignStmt->value, &valueUnsigned);
+				if (value == nullptr)
+					return false;
+				value = gen.autoTypeCast(value, elementType, valueUnsigned, vInfo->isUnsigned);
+				if (value == nullptr)
+					return false;
+				gen.builder->CreateStore(value, address);
+				return true;
+			}
+			if (vInfo->vType->isArrayTy() || vInfo->length != nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "Cannot assign to the array '%s' as a whole", gen.getName(assignStmt->ident).data());
+				return false;
+			}
+
+			bool valueUnsigned = false;
+			llvm::Value* value = gen.GenerateExpr(assignStmt->value, &valueUnsigned);
+			if (value == nullptr)
+				return false;
+			value = gen.autoTypeCast(value, vInfo->vType, valueUnsigned, vInfo->isUnsigned);
+			if (value == nullptr)
+				return false;
+
+			if (vInfo->vAddr != nullptr)
+				gen.builder->CreateStore(value, vInfo->vAddr);
+			else
+				gen.m_ssa.WriteVariable(vInfo->ssaVariable, gen.builder->GetInsertBlock(), value);
+			return true;
+		}
+		bool operator()(const ReturnStmt* retStmt)
+		{
+			llvm::Type* returnType = gen.m_FunctionType->getReturnType();
+			if ((retStmt->value == nullptr) != returnType->isVoidTy())
+			{
+				Logger::fmtLog(LogLevel::Error, "%s", returnType->isVoidTy() ? "A void function cannot return a value" : "Missing the value to return");
+				return false;
+			}
+			if (retStmt->value == nullptr)
+			{
+				gen.builder->CreateRetVoid();
+				return true;
+			}
+
+			bool valueUnsigned = false;
+			llvm::Value* value = gen.GenerateExpr(retStmt->value, &valueUnsigned);
+			if (value == nullptr)
+				return false;
+			value = gen.autoTypeCast(value, gen.m_FunctionType->getReturnType(), valueUnsigned, gen.m_returnsUnsigned);
+			if (value == nullptr)
+				return false;
+			gen.builder->CreateRet(value);
+			return true;
 		}
-		void operator()(const std::unique_ptr<ReturnStmt>& retStmt)
+		bool operator()(const CompoundStmt* compoundStmt)
 		{
-			gen.builder->CreateRet(gen.autoTypeCast(gen.GenerateExpr(retStmt->value), gen.m_FunctionType->getReturnType()));
+			gen.m_symbols.PushScope();
+			bool generated = gen.GenerateCompoundStatement(compoundStmt);
+			gen.m_symbols.PopScope();
+			return generated;
 		}
-		void operator()(const std::unique_ptr<CompoundStmt>& compoundStmt)
+		bool operator()(const FnCall* fnCall)
 		{
-			/*TODO*/
+			if (const Builtin* builtin = gen.findBuiltin(fnCall->name))
+				return gen.GenerateBuiltinCall(fnCall, *builtin) != nullptr;
+			return gen.CreateFunctionCall(fnCall) != nullptr;
 		}
-		void operator()(const std::unique_ptr<FnCall>& fnCall)
+		bool operator()(const ForStmt* forStmt)
 		{
-			gen.CreateFunctionCall(fnCall);
+			return gen.GenerateForStatement(forStmt);
 		}
 		Generator& gen;
 	};
 	stmtVisitor visitor = { *this };
-	std::visit(visitor, stmt->stmt);
+	return std::visit(visitor, stmt->stmt);
 }
 
-llvm::Value* Generator::GenerateExpr(const std::unique_ptr<Expr>& expr)
+bool Generator::GenerateForStatement(const ForStmt* forStmt)
 {
-	struct exprVisitor
+	// The counter is a signed i64, bounds of a signed type are sign extended so negative ones count from below zero
+	llvm::Type* indexType = builder->getInt64Ty();
+	bool startUnsigned = false, endUnsigned = false;
+	llvm::Value* start = GenerateExpr(forStmt->start, &startUnsigned);
+	if (start == nullptr || (start = autoTypeCast(start, indexType, startUnsigned)) == nullptr)
+		return false;
+	llvm::Value* end = GenerateExpr(forStmt->end, &endUnsigned);
+	if (end == nullptr || (end = autoTypeCast(end, indexType, endUnsigned)) == nullptr)
+		return false;
+
+	llvm::Function* fn = builder->GetInsertBlock()->getParent();
+	llvm::BasicBlock* header = llvm::BasicBlock::Create(*ctx, "for.cond", fn);
+	llvm::BasicBlock* body = llvm::BasicBlock::Create(*ctx, "for.body", fn);
+	llvm::BasicBlock* latch = llvm::BasicBlock::Create(*ctx, "for.inc", fn);
+	llvm::BasicBlock* exit = llvm::BasicBlock::Create(*ctx, "for.end", fn);
+
+	// The counter is an SSA variable like any local, reading it in the header places its phi
+	SSABuilder::Variable counter = m_ssa.NewVariable(indexType, getName(forStmt->ident));
+	m_ssa.WriteVariable(counter, builder->GetInsertBlock(), start);
+	builder->CreateBr(header);
+
+	// The header is sealed only once the latch branches back to it
+	builder->SetInsertPoint(header);
+	llvm::Value* index = m_ssa.ReadVariable(counter, header);
+	builder->CreateCondBr(builder->CreateICmpSLT(index, end, "for.cmp"), body, exit);
+
+	// The counter and the body share a scope, so the body cannot redeclare it
+	m_ssa.SealBlock(body);
+	builder->SetInsertPoint(body);
+	m_symbols.PushScope();
+	m_symbols.Declare(forStmt->ident, { nullptr, indexType, counter, nullptr, nullptr, true });
+	bool generated = GenerateCompoundStatement(forStmt->body);
+	m_symbols.PopScope();
+	if (!generated)
+		return false;
+
+	// A body ending in a return never reaches the latch
+	if (builder->GetInsertBlock()->getTerminator() == nullptr)
+		builder->CreateBr(latch);
+	if (llvm::pred_empty(latch))
+		latch->eraseFromParent();
+	else
 	{
-		llvm::Value* operator()(const std::unique_ptr<BinaryOp>& binop)
-		{
-			llvm::Value* LHS = std::visit(*this, binop->LHS->value);
-			llvm::Value* RHS = std::visit(*this, binop->RHS->value);
+		m_ssa.SealBlock(latch);
+		builder->SetInsertPoint(latch);
+		// counter < end <= INT64_MAX, the increment cannot overflow
+		llvm::Value* next = builder->CreateNSWAdd(m_ssa.ReadVariable(counter, latch), builder->getInt64(1), "for.next");
+		m_ssa.WriteVariable(counter, latch, next);
+		builder->CreateBr(header)->setMetadata(llvm::LLVMContext::MD_loop, CreateLoopMetadata());
+	}
+	m_ssa.SealBlock(header);
 
-			if (gen.getTypePriority(LHS->getType()) > gen.getTypePriority(RHS->getType()))
-				RHS = gen.autoTypeCast(RHS, LHS->getType());
-			else
-				LHS = gen.autoTypeCast(LHS, RHS->getType());
+	m_ssa.SealBlock(exit);
+	builder->SetInsertPoint(exit);
+	return true;
+}
+
+llvm::MDNode* Generator::CreateLoopMetadata()
+{
+	// A counted loop always terminates, mustprogress saves LLVM from proving it before it deletes or vectorizes the loop.
+	// Loop IDs are distinct and refer to themselves as their first operand
+	llvm::Metadata* mustProgress = llvm::MDNode::get(*ctx, llvm::MDString::get(*ctx, "llvm.loop.mustprogress"));
+	llvm::MDNode* loopID = llvm::MDNode::getDistinct(*ctx, { nullptr, mustProgress });
+	loopID->replaceOperandWith(0, loopID);
+	return loopID;
+}
+
+llvm::Value* Generator::GenerateExpr(const Expr* expr, bool* isUnsigned)
+{
+	// Operands always precede their users, so a single forward pass evaluates the whole tree
+	llvm::SmallVector<llvm::Value*, 16> values;
+	values.reserve(expr->nodes.size());
+	// Signedness of each value, literals and everything computed by negation are signed
+	llvm::SmallVector<bool, 16> unsignedValues;
+	unsignedValues.reserve(expr->nodes.size());
 
-			// For float types, the operation performed should be float op
-			if (LHS->getType()->isFloatingPointTy() || RHS->getType()->isFloatingPointTy())
+	for (const ExprNode& node : expr->nodes)
+	{
+		llvm::Value* value = nullptr;
+		bool valueUnsigned = false;
+		switch (node.kind)
+		{
+		case ExprKind::Literal:
+			value = GenerateLiteral(node.literal);
+			valueUnsigned = isUnsignedLiteral(node.literal);
+			break;
+		case ExprKind::Ident:
+		{
+			const varInfo* vInfo = m_symbols.Lookup(node.name);
+			if (vInfo == nullptr)
 			{
-				switch (binop->type) {
-				case TokenType::PLUS:
-					return gen.builder->CreateFAdd(LHS, RHS, "plustmp");
-				case TokenType::MINUS:
-					return gen.builder->CreateFSub(LHS, RHS, "subtmp");
-				case TokenType::STAR:
-					return gen.builder->CreateFMul(LHS, RHS, "multmp");
-				case TokenType::FORWARD_SLASH:
-					return gen.builder->CreateFDiv(LHS, RHS, "divtmp");
-				default:
-					Logger::fmtLog("Invalid binary operator found!");
-					return nullptr;
-				}
+				Logger::fmtLog(LogLevel::Error, "Use of undeclared identifier '%s'", getName(node.name).data());
+				return nullptr;
 			}
-
-			// Else perform Integer operations
-			switch (binop->type) {
-			case TokenType::PLUS:
-				return gen.builder->CreateAdd(LHS, RHS, "plustmp");
-			case TokenType::MINUS:
-				return gen.builder->CreateSub(LHS, RHS, "subtmp");
-			case TokenType::STAR:
-				return gen.builder->CreateMul(LHS, RHS, "multmp");
-			case TokenType::FORWARD_SLASH:
-				return gen.builder->CreateSDiv(LHS, RHS, "divtmp");
-			default:
-				Logger::fmtLog("Invalid binary operator found!");
+			if (vInfo->vType->isArrayTy() || vInfo->length != nullptr)
+			{
+				Logger::fmtLog(LogLevel::Error, "'%s' is an array, index it or pass it to a slice parameter", getName(node.name).data());
 				return nullptr;
 			}
+			value = ReadVariable(vInfo, node.name);
+			valueUnsigned = vInfo->isUnsigned;
 		}
-		llvm::Value* operator()(const std::unique_ptr<Literal>& lit)
+		break;
+		case ExprKind::Call:
+			if (const Builtin* builtin = findBuiltin(node.call->name))
+				value = GenerateBuiltinCall(node.call, *builtin);
+			else if ((value = CreateFunctionCall(node.call)) != nullptr)
+				valueUnsigned = isUnsignedType(m_FunctionMap.find(node.call->name)->second.fnStmt->returnType);
+			break;
+		case ExprKind::Unary:
+			value = GenerateUnaryOp(node.op, values[node.lhs]);
+			break;
+		case ExprKind::Index:
 		{
-			switch (lit->type)
-			{
-			case PrimitiveDataType::i32:
-				return llvm::ConstantInt::get(llvm::Type::getInt32Ty(*gen.ctx), llvm::APInt(32, lit->value, 10));
-			case PrimitiveDataType::f64:
-				return llvm::ConstantFP::get(llvm::Type::getDoubleTy(*gen.ctx), std::stod(lit->value));
-			case PrimitiveDataType::str:
+			// Indexing a vector reads one of its lanes
+			const varInfo* vInfo = m_symbols.Lookup(node.name);
+			valueUnsigned = vInfo != nullptr && vInfo->isUnsigned;
+			if (vInfo != nullptr && vInfo->vType->isVectorTy() && vInfo->length == nullptr)
 			{
-				// Create a string global variable
-				llvm::Value* strVal = gen.builder->CreateGlobalStringPtr(lit->value);
-				return strVal; // Return pointer to the string
-			}
-			default:
-				Logger::fmtLog(LogLevel::Error, "Unkown type literal found!");
-				return nullptr;
+				if (llvm::Value* index = GenerateLaneIndex(llvm::cast<llvm::FixedVectorType>(vInfo->vType), values[node.lhs], unsignedValues[node.lhs]))
+					value = builder->CreateExtractElement(ReadVariable(vInfo, node.name), index, getName(node.name) + "lane");
 				break;
 			}
+			llvm::Type* elementType = nullptr;
+			llvm::Value* address = GenerateElementAddress(node.name, values[node.lhs], unsignedValues[node.lhs], elementType);
+			if (address != nullptr)
+				value = builder->CreateLoad(elementType, address, getName(node.name) + "elem");
 		}
-		llvm::Value* operator()(const std::unique_ptr<Ident>& ident)
+		break;
+		case ExprKind::Binary:
 		{
-			if (gen.m_symbolMap.count(ident->name) == 1)
-			{
-				auto& vInfo = gen.m_symbolMap[ident->name];
-				return gen.builder->CreateLoad(vInfo.vType, vInfo.vAddr, ident->name + "load");
-			}
+			// Signedness of the operand the other is cast to, a mix of equal priority is unsigned like in C
+			int lhsPriority = getTypePriority(values[node.lhs]->getType());
+			int rhsPriority = getTypePriority(values[node.rhs]->getType());
+			bool lhsUnsigned = unsignedValues[node.lhs], rhsUnsigned = unsignedValues[node.rhs];
+			valueUnsigned = lhsPriority > rhsPriority ? lhsUnsigned : lhsPriority < rhsPriority ? rhsUnsigned : lhsUnsigned || rhsUnsigned;
+			value = GenerateBinaryOp(node.op, values[node.lhs], values[node.rhs], lhsUnsigned, rhsUnsigned, valueUnsigned);
+		}
+		break;
+		}
 
+		if (value == nullptr)
+			return nullptr;
+		values.push_back(value);
+		unsignedValues.push_back(valueUnsigned);
+	}
+
+	if (isUnsigned != nullptr)
+		*isUnsigned = unsignedValues.back();
+	return values.back();
+}
+
+llvm::Value* Generator::ReadVariable(const varInfo* vInfo, SymbolID name)
+{
+	if (vInfo->constant != nullptr)
+		return vInfo->constant;
+	if (vInfo->vAddr != nullptr)
+		return builder->CreateLoad(vInfo->vType, vInfo->vAddr, getName(name) + "load");
+	return m_ssa.ReadVariable(vInfo->ssaVariable, builder->GetInsertBlock());
+}
+
+llvm::Value* Generator::GenerateLaneIndex(llvm::FixedVectorType* vectorType, llvm::Value* index, bool indexUnsigned)
+{
+	// A negative lane is sign extended, so the check below catches it as a huge one
+	index = autoTypeCast(index, builder->getInt64Ty(), indexUnsigned);
+	if (index == nullptr)
+		return nullptr;
+	// A lane past the end reads poison, only a constant index can be checked
+	auto* constant = llvm::dyn_cast<llvm::ConstantInt>(index);
+	if (constant != nullptr && constant->getValue().uge(vectorType->getNumElements()))
+	{
+		Logger::fmtLog(LogLevel::Error, "Lane %lld is out of range of a vector of %u lanes", (long long)constant->getSExtValue(), vectorType->getNumElements());
+		return nullptr;
+	}
+	return index;
+}
+
+llvm::Value* Generator::GenerateElementAddress(SymbolID name, llvm::Value* index, bool indexUnsigned, llvm::Type*& elementType)
+{
+	const varInfo* vInfo = m_symbols.Lookup(name);
+	if (vInfo == nullptr)
+	{
+		Logger::fmtLog(LogLevel::Error, "Use of undeclared identifier '%s'", getName(name).data());
+		return nullptr;
+	}
+
+	// Indices are i64 like the loop counter, so indexing inside a loop needs no extension. A signed index is sign
+	// extended, the GEPs below take it as signed
+	index = autoTypeCast(index, builder->getInt64Ty(), indexUnsigned);
+	if (index == nullptr)
+		return nullptr;
+
+	// Not bounds checked, inbounds lets alias analysis and the vectorizer reason about the access
+	if (vInfo->vType->isArrayTy())
+	{
+		elementType = vInfo->vType->getArrayElementType();
+		return builder->CreateInBoundsGEP(vInfo->vType, vInfo->vAddr, { builder->getInt64(0), index }, getName(name) + "idx");
+	}
+	if (vInfo->length != nullptr)
+	{
+		elementType = vInfo->vType;
+		return builder->CreateInBoundsGEP(vInfo->vType, vInfo->vAddr, index, getName(name) + "idx");
+	}
+	Logger::fmtLog(LogLevel::Error, "'%s' is not an array or slice", getName(name).data());
+	return nullptr;
+}
+
+llvm::Value* Generator::GenerateBinaryOp(TokenType op, llvm::Value* LHS, llvm::Value* RHS, bool lhsUnsigned, bool rhsUnsigned, bool isUnsigned)
+{
+	if (getTypePriority(LHS->getType()) > getTypePriority(RHS->getType()))
+		RHS = autoTypeCast(RHS, LHS->getType(), rhsUnsigned);
+	else
+		LHS = autoTypeCast(LHS, RHS->getType(), lhsUnsigned);
+	if (LHS == nullptr || RHS == nullptr)
+		return nullptr;
+
+	// For float types, the operation performed should be float op. Vectors take the same path, lane by lane
+	if (LHS->getType()->isFPOrFPVectorTy() || RHS->getType()->isFPOrFPVectorTy())
+	{
+		switch (op) {
+		case TokenType::PLUS:
+			return builder->CreateFAdd(LHS, RHS, "plustmp");
+		case TokenType::MINUS:
+			return builder->CreateFSub(LHS, RHS, "subtmp");
+		case TokenType::STAR:
+			return builder->CreateFMul(LHS, RHS, "multmp");
+		case TokenType::FORWARD_SLASH:
+			return builder->CreateFDiv(LHS, RHS, "divtmp");
+		case TokenType::MODULUS:
+			return builder->CreateFRem(LHS, RHS, "modtmp");
+		case TokenType::EQUALITY:
+			return builder->CreateFCmpOEQ(LHS, RHS, "eqtmp");
+		case TokenType::NOT_EQUAL:
+			return builder->CreateFCmpUNE(LHS, RHS, "netmp");
+		case TokenType::LESS_THAN:
+			return builder->CreateFCmpOLT(LHS, RHS, "lttmp");
+		case TokenType::LESS_EQUAL:
+			return builder->CreateFCmpOLE(LHS, RHS, "letmp");
+		case TokenType::GREATER_THAN:
+			return builder->CreateFCmpOGT(LHS, RHS, "gttmp");
+		case TokenType::GREATER_EQUAL:
+			return builder->CreateFCmpOGE(LHS, RHS, "getmp");
+		default:
+			Logger::fmtLog("Invalid binary operator found!");
 			return nullptr;
 		}
-		llvm::Value* operator()(const std::unique_ptr<FnCall>& fnCall)
-		{
-			return gen.CreateFunctionCall(fnCall);
-		}
+	}
 
-		Generator& gen;
-	};
+	// Else perform Integer operations, isUnsigned is the signedness both operands were promoted to
+	switch (op) {
+	case TokenType::PLUS:
+		return builder->CreateAdd(LHS, RHS, "plustmp");
+	case TokenType::MINUS:
+		return builder->CreateSub(LHS, RHS, "subtmp");
+	case TokenType::STAR:
+		return builder->CreateMul(LHS, RHS, "multmp");
+	case TokenType::FORWARD_SLASH:
+		return isUnsigned ? builder->CreateUDiv(LHS, RHS, "divtmp") : builder->CreateSDiv(LHS, RHS, "divtmp");
+	case TokenType::MODULUS:
+		return isUnsigned ? builder->CreateURem(LHS, RHS, "modtmp") : builder->CreateSRem(LHS, RHS, "modtmp");
+	// Comparisons give an i1, autoTypeCast zero extends it wherever a wider integer is expected
+	case TokenType::EQUALITY:
+		return builder->CreateICmpEQ(LHS, RHS, "eqtmp");
+	case TokenType::NOT_EQUAL:
+		return builder->CreateICmpNE(LHS, RHS, "netmp");
+	case TokenType::LESS_THAN:
+		return builder->CreateICmp(isUnsigned ? llvm::CmpInst::ICMP_ULT : llvm::CmpInst::ICMP_SLT, LHS, RHS, "lttmp");
+	case TokenType::LESS_EQUAL:
+		return builder->CreateICmp(isUnsigned ? llvm::CmpInst::ICMP_ULE : llvm::CmpInst::ICMP_SLE, LHS, RHS, "letmp");
+	case TokenType::GREATER_THAN:
+		return builder->CreateICmp(isUnsigned ? llvm::CmpInst::ICMP_UGT : llvm::CmpInst::ICMP_SGT, LHS, RHS, "gttmp");
+	case TokenType::GREATER_EQUAL:
+		return builder->CreateICmp(isUnsigned ? llvm::CmpInst::ICMP_UGE : llvm::CmpInst::ICMP_SGE, LHS, RHS, "getmp");
+	default:
+		Logger::fmtLog("Invalid binary operator found!");
+		return nullptr;
+	}
+}
+
+llvm::Value* Generator::GenerateUnaryOp(TokenType op, llvm::Value* operand)
+{
+	switch (op) {
+	case TokenType::MINUS:
+		if (operand->getType()->isFPOrFPVectorTy())
+			return builder->CreateFNeg(operand, "negtmp");
+		return builder->CreateNeg(operand, "negtmp");
+	default:
+		Logger::fmtLog("Invalid unary operator found!");
+		return nullptr;
+	}
+}
 
-	exprVisitor visitor = { *this };
-	return std::visit(visitor, expr->value);
+llvm::Value* Generator::GenerateLiteral(const Literal* lit)
+{
+	switch (lit->type)
+	{
+	case PrimitiveDataType::i32:
+		return llvm::ConstantInt::get(llvm::Type::getInt32Ty(*ctx), llvm::APInt(32, lit->value, 10));
+	case PrimitiveDataType::f64:
+		return llvm::ConstantFP::get(llvm::Type::getDoubleTy(*ctx), std::stod(std::string(lit->value)));
+	case PrimitiveDataType::i1:
+		return llvm::ConstantInt::get(llvm::Type::getInt1Ty(*ctx), lit->value == "1");
+	case PrimitiveDataType::str:
+	{
+		// Create a string global variable, the module is passed for global initializers which have no insert point
+		llvm::Value* strVal = builder->CreateGlobalStringPtr(lit->value, "", 0, cModule.get());
+		return strVal; // Return pointer to the string
+	}
+	default:
+		Logger::fmtLog(LogLevel::Error, "Unkown type literal found!");
+		return nullptr;
+	}
 }
 
-void Generator::saveModuleToFile() const
+bool Generator::saveModuleToFile() const
 {
 	std::error_code errorCode;
 	llvm::raw_fd_ostream outLLFile(m_outPath, errorCode);
+	if (errorCode)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not open '%s': %s", m_outPath.c_str(), errorCode.message().c_str());
+		return false;
+	}
 
 	cModule->print(outLLFile, nullptr);
+	return true;
+}
+bool Generator::saveBitcodeToFile() const
+{
+	std::error_code errorCode;
+	llvm::raw_fd_ostream outBCFile(m_outPath, errorCode, llvm::sys::fs::OF_None);
+	if (errorCode)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not open '%s': %s", m_outPath.c_str(), errorCode.message().c_str());
+		return false;
+	}
 
+	llvm::WriteBitcodeToFile(*cModule, outBCFile);
+	return true;
 }
+
+llvm::orc::ThreadSafeModule Generator::takeModule()
+{
+	builder.reset();
+	return llvm::orc::ThreadSafeModule(std::move(cModule), std::move(ctx));
+}
+
 void Generator::moduleInit()
 {
 	ctx = std::make_unique<llvm::LLVMContext>();
@@ -334,20 +1506,56 @@ int Generator::getTypePriority(llvm::Type* type)
 	else if (type->isVoidTy()) {
 		return 0; // Void types have the lowest priority
 	}
+	else if (auto* vectorType = llvm::dyn_cast<llvm::FixedVectorType>(type)) {
+		return 1000 + getTypePriority(vectorType->getElementType()); // Scalars are splat to vectors, lanes convert like scalars
+	}
 	// PLUS more type categories as needed
 	return -1; // Unknown types have lowest priority
 }
-llvm::Value* Generator::autoTypeCast(llvm::Value* val, llvm::Type* targetType) const {
+llvm::Value* Generator::autoTypeCast(llvm::Value* val, llvm::Type* targetType, bool isUnsigned, bool targetUnsigned) const {
 	llvm::Type* valType = val->getType();
 
 	if (valType == targetType)
 		return val; // No cast needed
 
+	// The i1 of a comparison is 0 or 1, never -1
+	bool zeroExtend = isUnsigned || valType->getScalarType()->isIntegerTy(1);
+
+	// Vectors convert lane by lane, a scalar is converted to the element type and splat to every lane
+	if (auto* targetVector = llvm::dyn_cast<llvm::FixedVectorType>(targetType)) {
+		auto* valVector = llvm::dyn_cast<llvm::FixedVectorType>(valType);
+		if (valVector == nullptr && (valType->isIntegerTy() || valType->isFloatingPointTy())) {
+			llvm::Value* lane = autoTypeCast(val, targetVector->getElementType(), isUnsigned, targetUnsigned);
+			if (lane == nullptr)
+				return nullptr;
+			if (llvm::Constant* constLane = llvm::dyn_cast<llvm::Constant>(lane))
+				return llvm::ConstantVector::getSplat(targetVector->getElementCount(), constLane);
+			return builder->CreateVectorSplat(targetVector->getNumElements(), lane, "splat");
+		}
+		if (valVector != nullptr && valVector->getNumElements() == targetVector->getNumElements()) {
+			// The builder folds constant operands, so global initializers stay constants
+			llvm::Type* from = valVector->getElementType();
+			llvm::Type* to = targetVector->getElementType();
+			if (from->isIntegerTy() && to->isIntegerTy()) {
+				if (from->getIntegerBitWidth() >= to->getIntegerBitWidth())
+					return builder->CreateTrunc(val, targetType, "trunc");
+				return zeroExtend ? builder->CreateZExt(val, targetType, "zext") : builder->CreateSExt(val, targetType, "sext");
+			}
+			if (from->isFloatingPointTy() && to->isFloatingPointTy())
+				return builder->CreateFPCast(val, targetType, "fpcast");
+			if (to->isFloatingPointTy())
+				return zeroExtend ? builder->CreateUIToFP(val, targetType, "uitofp") : builder->CreateSIToFP(val, targetType, "sitofp");
+			return targetUnsigned ? builder->CreateFPToUI(val, targetType, "fptoui") : builder->CreateFPToSI(val, targetType, "fptosi");
+		}
+	}
+
 	// Handle constant values
 	if (llvm::Constant* constVal = llvm::dyn_cast<llvm::Constant>(val)) {
 		if (valType->isIntegerTy() && targetType->isIntegerTy()) {
 			if (valType->getIntegerBitWidth() < targetType->getIntegerBitWidth()) {
-				return llvm::ConstantExpr::getZExtOrBitCast(constVal, targetType);
+				if (zeroExtend)
+					return llvm::ConstantExpr::getZExtOrBitCast(constVal, targetType);
+				return llvm::ConstantExpr::getSExtOrBitCast(constVal, targetType);
 			}
 			else if (valType->getIntegerBitWidth() > targetType->getIntegerBitWidth()) {
 				return llvm::ConstantExpr::getTruncOrBitCast(constVal, targetType);
@@ -366,9 +1574,13 @@ llvm::Value* Generator::autoTypeCast(llvm::Value* val, llvm::Type* targetType) c
 			return llvm::ConstantExpr::getFPCast(constVal, targetType);
 		}
 		else if (targetType->isFloatingPointTy() && valType->isIntegerTy()) {
+			if (zeroExtend)
+				return llvm::ConstantExpr::getUIToFP(constVal, targetType);
 			return llvm::ConstantExpr::getSIToFP(constVal, targetType);
 		}
 		else if (targetType->isIntegerTy() && valType->isFloatingPointTy()) {
+			if (targetUnsigned)
+				return llvm::ConstantExpr::getFPToUI(constVal, targetType);
 			return llvm::ConstantExpr::getFPToSI(constVal, targetType);
 		}
 	}
@@ -378,7 +1590,9 @@ llvm::Value* Generator::autoTypeCast(llvm::Value* val, llvm::Type* targetType) c
 		unsigned valWidth = valType->getIntegerBitWidth();
 
 		if (valWidth < targetWidth) {
-			return builder->CreateZExtOrBitCast(val, targetType, "zext");
+			if (zeroExtend)
+				return builder->CreateZExtOrBitCast(val, targetType, "zext");
+			return builder->CreateSExtOrBitCast(val, targetType, "sext");
 		}
 		else if (valWidth > targetWidth) {
 			return builder->CreateTruncOrBitCast(val, targetType, "trunc");
@@ -397,13 +1611,21 @@ llvm::Value* Generator::autoTypeCast(llvm::Value* val, llvm::Type* targetType) c
 		return builder->CreateFPCast(val, targetType, "fpcast");
 	}
 	else if (targetType->isFloatingPointTy() && valType->isIntegerTy()) {
+		if (zeroExtend)
+			return builder->CreateUIToFP(val, targetType, "uitofp");
 		return builder->CreateSIToFP(val, targetType, "sitofp");
 	}
 	else if (targetType->isIntegerTy() && valType->isFloatingPointTy()) {
+		if (targetUnsigned)
+			return builder->CreateFPToUI(val, targetType, "fptoui");
 		return builder->CreateFPToSI(val, targetType, "fptosi");
 	}
 
-	llvm::errs() << "Unsupported cast from " << *valType << " to " << *targetType << "\n";
+	std::string from, to;
+	llvm::raw_string_ostream fromStream(from), toStream(to);
+	fromStream << *valType;
+	toStream << *targetType;
+	Logger::fmtLog(LogLevel::Error, "Unsupported cast from %s to %s", fromStream.str().c_str(), toStream.str().c_str());
 	return nullptr;
 }
 llvm::Type* Generator::findTypeFromPrimitive(PrimitiveDataType pdt)
@@ -411,4 +1633,9 @@ llvm::Type* Generator::findTypeFromPrimitive(PrimitiveDataType pdt)
 	if (m_TypeMap.count(pdt) > 0)
 		return m_TypeMap[pdt];
 	return nullptr;
+}
+llvm::StringRef Generator::getName(SymbolID id) const
+{
+	std::string_view name = m_interner.getString(id);
+	return llvm::StringRef(name.data(), name.size());
 }
\ No newline at end of file
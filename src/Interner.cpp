@@ -0,0 +1,107 @@
+#include "headers/Interner.h"
+
+#include <cstring>
+
+StringInterner::StringInterner()
+{
+	// Slot 0 is INVALID_SYMBOL
+	m_strings.emplace_back();
+	m_hashes.push_back(0);
+	m_table.assign(256, INVALID_SYMBOL);
+}
+
+SymbolID StringInterner::Intern(std::string_view str)
+{
+	uint32_t h = hash(str);
+	size_t mask = m_table.size() - 1;
+
+	for (size_t slot = h & mask;; slot = (slot + 1) & mask)
+	{
+		SymbolID id = m_table[slot];
+		if (id == INVALID_SYMBOL)
+		{
+			id = static_cast<SymbolID>(m_strings.size());
+			m_strings.emplace_back(CopyToArena(str), str.size());
+			m_hashes.push_back(h);
+			m_table[slot] = id;
+
+			// Keep the load factor under 1/2
+			if (m_strings.size() * 2 > m_table.size())
+				Rehash(m_table.size() * 2);
+			return id;
+		}
+		if (m_hashes[id] == h && m_strings[id] == str)
+			return id;
+	}
+}
+
+SymbolID StringInterner::find(std::string_view str) const
+{
+	uint32_t h = hash(str);
+	size_t mask = m_table.size() - 1;
+
+	for (size_t slot = h & mask;; slot = (slot + 1) & mask)
+	{
+		SymbolID id = m_table[slot];
+		if (id == INVALID_SYMBOL)
+			return INVALID_SYMBOL;
+		if (m_hashes[id] == h && m_strings[id] == str)
+			return id;
+	}
+}
+
+std::string_view StringInterner::getString(SymbolID id) const
+{
+	return m_strings[id];
+}
+
+size_t StringInterner::size() const
+{
+	return m_strings.size() - 1;
+}
+
+const char* StringInterner::CopyToArena(std::string_view str)
+{
+	size_t needed = str.size() + 1;
+	if (needed > m_remaining)
+	{
+		size_t blockSize = needed > BLOCK_SIZE ? needed : BLOCK_SIZE;
+		m_blocks.emplace_back(new char[blockSize]);
+		m_cursor = m_blocks.back().get();
+		m_remaining = blockSize;
+	}
+
+	char* dst = m_cursor;
+	std::memcpy(dst, str.data(), str.size());
+	dst[str.size()] = '\0';
+
+	m_cursor += needed;
+	m_remaining -= needed;
+	return dst;
+}
+
+void StringInterner::Rehash(size_t newCapacity)
+{
+	m_table.assign(newCapacity, INVALID_SYMBOL);
+	size_t mask = newCapacity - 1;
+
+	for (SymbolID id = 1; id < m_strings.size(); id++)
+	{
+		size_t slot = m_hashes[id] & mask;
+		while (m_table[slot] != INVALID_SYMBOL)
+			slot = (slot + 1) & mask;
+		m_table[slot] = id;
+	}
+}
+
+uint32_t StringInterner::hash(std::string_view str)
+{
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	for (char c : str)
+	{
+		h ^= static_cast<unsigned char>(c);
+		h *= 16777619u;
+	}
+	return h;
+}
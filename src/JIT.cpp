@@ -0,0 +1,120 @@
+#include "headers/JIT.h"
+#include "headers/Logger.h"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/TargetExecutionUtils.h>
+#include <llvm/Support/Host.h>
+
+bool JIT::Init(const llvm::TargetMachine& targetMachine, bool lazy, unsigned compileThreads)
+{
+	const llvm::Triple& triple = targetMachine.getTargetTriple();
+	llvm::Triple host(llvm::sys::getProcessTriple());
+	if (triple.getArch() != host.getArch() || triple.getOS() != host.getOS())
+	{
+		Logger::fmtLog(LogLevel::Error, "Cannot run code for target '%s' on host '%s'", triple.str().c_str(), host.str().c_str());
+		return false;
+	}
+
+	// Same CPU, features and code generation level as an object file would get
+	llvm::orc::JITTargetMachineBuilder machineBuilder(triple);
+	machineBuilder.setCPU(targetMachine.getTargetCPU().str());
+	machineBuilder.addFeatures({ targetMachine.getTargetFeatureString().str() });
+	machineBuilder.setCodeGenOptLevel(targetMachine.getOptLevel());
+
+	llvm::Error error = llvm::Error::success();
+	if (lazy)
+	{
+		auto jit = llvm::orc::LLLazyJITBuilder()
+			.setJITTargetMachineBuilder(std::move(machineBuilder))
+			.setNumCompileThreads(compileThreads)
+			.create();
+		if (jit)
+		{
+			m_lazyJIT = jit->get();
+			m_jit = std::move(*jit);
+		}
+		else
+			error = jit.takeError();
+	}
+	else
+	{
+		auto jit = llvm::orc::LLJITBuilder()
+			.setJITTargetMachineBuilder(std::move(machineBuilder))
+			.setNumCompileThreads(compileThreads)
+			.create();
+		if (jit)
+			m_jit = std::move(*jit);
+		else
+			error = jit.takeError();
+	}
+	if (error)
+	{
+		Logger::fmtLog(LogLevel::Error, "Failed to create the JIT: %s", llvm::toString(std::move(error)).c_str());
+		return false;
+	}
+
+	// Anything the module does not define, like printf, is looked up in this process
+	auto processSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(m_jit->getDataLayout().getGlobalPrefix());
+	if (!processSymbols)
+	{
+		Logger::fmtLog(LogLevel::Error, "Failed to load the symbols of the process: %s", llvm::toString(processSymbols.takeError()).c_str());
+		return false;
+	}
+	m_jit->getMainJITDylib().addGenerator(std::move(*processSymbols));
+	return true;
+}
+
+bool JIT::AddModule(llvm::orc::ThreadSafeModule module)
+{
+	// The signature of main decides how it is called, read it before the JIT owns the module
+	module.withModuleDo([this](llvm::Module& m)
+	{
+		llvm::Function* mainFn = m.getFunction("main");
+		if (mainFn == nullptr || mainFn->isDeclaration())
+			return;
+		m_hasMain = true;
+		m_mainReturnsVoid = mainFn->getReturnType()->isVoidTy();
+	});
+
+	llvm::Error error = m_lazyJIT != nullptr
+		? m_lazyJIT->addLazyIRModule(std::move(module))
+		: m_jit->addIRModule(std::move(module));
+	if (error)
+	{
+		Logger::fmtLog(LogLevel::Error, "Failed to add the module to the JIT: %s", llvm::toString(std::move(error)).c_str());
+		return false;
+	}
+	return true;
+}
+
+bool JIT::LookupMain()
+{
+	if (!m_hasMain)
+	{
+		Logger::fmtLog(LogLevel::Error, "The program has no main function to run");
+		return false;
+	}
+
+	auto mainSymbol = m_jit->lookup("main");
+	if (!mainSymbol)
+	{
+		Logger::fmtLog(LogLevel::Error, "Failed to compile main: %s", llvm::toString(mainSymbol.takeError()).c_str());
+		return false;
+	}
+	m_mainAddress = mainSymbol->getAddress();
+	return true;
+}
+
+int JIT::RunMain(const std::string& programName, const std::vector<std::string>& args)
+{
+	if (m_mainReturnsVoid)
+	{
+		auto mainFn = llvm::jitTargetAddressToFunction<void (*)()>(m_mainAddress);
+		mainFn();
+		return 0;
+	}
+
+	auto mainFn = llvm::jitTargetAddressToFunction<int (*)(int, char*[])>(m_mainAddress);
+	return llvm::orc::runAsMain(mainFn, args, llvm::StringRef(programName));
+}
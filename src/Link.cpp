@@ -0,0 +1,56 @@
+#include "headers/Link.h"
+#include "headers/Logger.h"
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Program.h>
+
+bool LinkExecutable(const std::vector<std::string>& objects, const std::string& outputPath, const std::string& linker)
+{
+#ifdef _WIN32
+	std::string driverName = linker.empty() ? "clang" : linker;
+#else
+	std::string driverName = linker.empty() ? "cc" : linker;
+#endif
+
+	auto driver = llvm::sys::findProgramByName(driverName);
+	if (!driver)
+	{
+		Logger::fmtLog(LogLevel::Error, "Could not find the linker '%s' in PATH", driverName.c_str());
+		return false;
+	}
+
+	std::vector<llvm::StringRef> args;
+	args.push_back(*driver);
+	for (const std::string& object : objects)
+		args.push_back(object);
+	args.push_back("-o");
+	args.push_back(outputPath);
+
+	// When the log is captured (veritasd) the linker's own messages are captured with it
+	llvm::SmallString<128> linkerOutput;
+	bool captureOutput = Logger::GetThreadSink() != nullptr && !llvm::sys::fs::createTemporaryFile("veritas-link", "txt", linkerOutput);
+	llvm::Optional<llvm::StringRef> redirects[] = { llvm::None, llvm::StringRef(linkerOutput), llvm::StringRef(linkerOutput) };
+
+	std::string errorMessage;
+	int result = llvm::sys::ExecuteAndWait(*driver, args, llvm::None, captureOutput ? redirects : llvm::ArrayRef<llvm::Optional<llvm::StringRef>>(), 0, 0, &errorMessage);
+	if (captureOutput)
+	{
+		if (auto output = llvm::MemoryBuffer::getFile(linkerOutput))
+			if ((*output)->getBufferSize() != 0)
+				Logger::Log(LogLevel::None, (*output)->getBuffer().str());
+		llvm::sys::fs::remove(linkerOutput);
+	}
+	if (result != 0)
+	{
+		if (errorMessage.empty())
+			Logger::fmtLog(LogLevel::Error, "Linking '%s' failed, '%s' exited with %d", outputPath.c_str(), driverName.c_str(), result);
+		else
+			Logger::fmtLog(LogLevel::Error, "Linking '%s' failed: %s", outputPath.c_str(), errorMessage.c_str());
+		return false;
+	}
+	return true;
+}
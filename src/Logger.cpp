@@ -3,13 +3,27 @@
 //Set default value of _level
 LogLevel Logger::_level = LogLevel::Info;
 
+static thread_local LogSink* t_sink = nullptr;
+
+void LogSink::Append(const std::string& text)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_text += text;
+}
+
+std::string LogSink::Take()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return std::move(m_text);
+}
+
 //Constructor
 Logger::Logger() {}
 
 //Public Functions 
 void Logger::Log(const std::string& message) /*Assume the log level to be none*/
 {
-	std::cout << GREEN_COLOR << "[] " << RESET_COLOR << message;
+	Write(GREEN_COLOR "[] " RESET_COLOR + message);
 }
 
 void Logger::Log(LogLevel level, const std::string& message)
@@ -28,7 +42,7 @@ void Logger::Log(LogLevel level, const std::string& message)
 		LogError(message);
 		break;
 	case None:
-		std::cout << RESET_COLOR << message;
+		Write(RESET_COLOR + message);
 		break;
 	default:
 		break;
@@ -42,38 +56,34 @@ void Logger::fmtLog(LogLevel level, const char *const message, ...)
 
 	va_list args;
 	va_start(args, message);
+	std::string text = vformat(message, args);
+	va_end(args);
+
 	switch (level)
 	{
 	case Info:
-		std::cout << BLUE_COLOR << "[INFO]: " << RESET_COLOR;
-		vprintf(message, args);
-
+		Write(BLUE_COLOR "[INFO]: " RESET_COLOR + text + "\n");
 		break;
 	case Warning:
-		std::cout << YELLOW_COLOR << "[WARN]: " << RESET_COLOR;
-		vprintf(message, args);
+		Write(YELLOW_COLOR "[WARN]: " RESET_COLOR + text + "\n");
 		break;
 	case Error:
-		std::cout << RED_COLOR << "[ERROR]: " << RESET_COLOR;
-		vprintf(message, args);
+		Write(RED_COLOR "[ERROR]: " RESET_COLOR + text + "\n");
 		break;
 	case None:
-
-		vprintf(message, args);
+		Write(text + "\n");
 		break;
 	}
-	va_end(args);
-	printf("\n");
 }
 
 void Logger::fmtLog(const char* message, ...) /* Assume the log level to be none */
 {
 	va_list args;
 	va_start(args, message);
-	vprintf(message, args);
+	std::string text = vformat(message, args);
 	va_end(args);
 
-	printf("\n");
+	Write(text + "\n");
 }
 
 void Logger::SetLogLevel(LogLevel level) 
@@ -86,18 +96,50 @@ LogLevel Logger::GetLogLevel()
 	return _level; 
 }
 
+void Logger::SetThreadSink(LogSink* sink)
+{
+	t_sink = sink;
+}
+
+LogSink* Logger::GetThreadSink()
+{
+	return t_sink;
+}
+
 //Private Functions
 void Logger::LogInfo(const std::string& message)
 {
-	std::cout << BLUE_COLOR << "[INFO]: " << RESET_COLOR << message << std::endl;
+	Write(BLUE_COLOR "[INFO]: " RESET_COLOR + message + "\n");
 }
 
 void Logger::LogWarning(const std::string& message)
 {
-	std::cout << YELLOW_COLOR << "[WARN]: " << RESET_COLOR << message << std::endl;
+	Write(YELLOW_COLOR "[WARN]: " RESET_COLOR + message + "\n");
 }
 
 void Logger::LogError(const std::string& message)
 {
-	std::cout << RED_COLOR << "[ERROR]: " << RESET_COLOR << message << std::endl;
+	Write(RED_COLOR "[ERROR]: " RESET_COLOR + message + "\n");
+}
+
+void Logger::Write(const std::string& text)
+{
+	if (t_sink != nullptr)
+		t_sink->Append(text);
+	else
+		std::cout << text << std::flush;
+}
+
+std::string Logger::vformat(const char* message, va_list args)
+{
+	va_list sizeArgs;
+	va_copy(sizeArgs, args);
+	int size = vsnprintf(nullptr, 0, message, sizeArgs);
+	va_end(sizeArgs);
+	if (size <= 0)
+		return std::string();
+
+	std::string text(size, '\0');
+	vsnprintf(&text[0], text.size() + 1, message, args);
+	return text;
 }
@@ -0,0 +1,321 @@
+#include "headers/Options.h"
+#include "headers/Logger.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <string_view>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/Threading.h>
+
+// Matches "--name=value" and "-name=value" style options, value receives what follows the '='
+static bool matchValue(std::string_view arg, std::string_view name, std::string& value)
+{
+	if (arg.size() <= name.size() || arg.compare(0, name.size(), name) != 0 || arg[name.size()] != '=')
+		return false;
+	value = arg.substr(name.size() + 1);
+	return true;
+}
+
+bool ParseCommandLine(int argc, char* argv[], CompileOptions& options)
+{
+	int first = 1;
+	if (argc > 1 && std::string_view(argv[1]) == "run")
+	{
+		options.run = true;
+		first = 2;
+	}
+	else if (argc > 1 && std::string_view(argv[1]) == "daemon")
+	{
+		options.daemon = true;
+		first = 2;
+	}
+	else if (argc > 1 && std::string_view(argv[1]) == "bench")
+	{
+		std::string_view kind = argc > 2 ? argv[2] : "";
+		if (kind == "parse")
+			options.benchKind = BenchKind::Parse;
+		else if (kind == "expr")
+			options.benchKind = BenchKind::Expressions;
+		else if (kind == "keywords")
+			options.benchKind = BenchKind::Keywords;
+		else
+		{
+			Logger::fmtLog(LogLevel::Error, "Unknown benchmark '%s', expected parse, expr or keywords", std::string(kind).c_str());
+			return false;
+		}
+		options.bench = true;
+		first = 3;
+	}
+	else if (argc > 0 && std::filesystem::path(argv[0]).stem() == "veritasd")
+		options.daemon = true;
+
+	for (int i = first; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+		std::string value;
+
+		if (options.run && arg == "--")
+		{
+			options.programArgs.assign(argv + i + 1, argv + argc);
+			break;
+		}
+		else if (arg == "--help" || arg == "-h")
+			options.showHelp = true;
+		else if (arg == "--time-report")
+			options.timeReport = ReportFormat::Text;
+		else if (arg == "--time-report=json")
+			options.timeReport = ReportFormat::JSON;
+		else if (arg == "--time-report=text")
+			options.timeReport = ReportFormat::Text;
+		else if (arg == "-O0")
+			options.optLevel = OptLevel::O0;
+		else if (arg == "-O1")
+			options.optLevel = OptLevel::O1;
+		else if (arg == "-O2" || arg == "-O")
+			options.optLevel = OptLevel::O2;
+		else if (arg == "-O3")
+			options.optLevel = OptLevel::O3;
+		else if (arg == "-Os")
+			options.optLevel = OptLevel::Os;
+		else if (arg == "-Oz")
+			options.optLevel = OptLevel::Oz;
+		else if (arg == "--verify-each")
+			options.verifyEach = true;
+		else if (arg == "--print-ir")
+			options.printIR = true;
+		else if (arg == "--lazy")
+			options.lazyJIT = true;
+		else if (arg == "-j" || (arg.size() > 2 && arg.compare(0, 2, "-j") == 0))
+		{
+			// Both "-j 8" and "-j8"
+			if (arg.size() > 2)
+				value = arg.substr(2);
+			else if (i + 1 < argc)
+				value = argv[++i];
+			char* end = nullptr;
+			unsigned long jobs = std::strtoul(value.c_str(), &end, 10);
+			if (value.empty() || *end != '\0' || jobs > 1024)
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid job count '%s'", value.c_str());
+				return false;
+			}
+			options.jobs = static_cast<unsigned>(jobs);
+		}
+		else if (arg == "-o")
+		{
+			if (i + 1 >= argc)
+			{
+				Logger::fmtLog(LogLevel::Error, "Missing file name after '-o'");
+				return false;
+			}
+			options.outputPath = argv[++i];
+		}
+		else if (matchValue(arg, "--emit", value))
+		{
+			if (value == "llvm")
+				options.emit = EmitKind::LLVM;
+			else if (value == "bc")
+				options.emit = EmitKind::Bitcode;
+			else if (value == "asm")
+				options.emit = EmitKind::Assembly;
+			else if (value == "obj")
+				options.emit = EmitKind::Object;
+			else if (value == "exe")
+				options.emit = EmitKind::Executable;
+			else
+			{
+				Logger::fmtLog(LogLevel::Error, "Unknown emit kind '%s'", value.c_str());
+				return false;
+			}
+		}
+		else if (matchValue(arg, "--target", value))
+			options.targetTriple = value;
+		else if (matchValue(arg, "-march", value))
+			options.arch = value;
+		else if (matchValue(arg, "-mcpu", value))
+			options.cpu = value;
+		else if (matchValue(arg, "-mattr", value))
+			options.features = value;
+		else if (matchValue(arg, "--linker", value))
+			options.linker = value;
+		else if (matchValue(arg, "--cache-dir", value))
+			options.cacheDir = value;
+		else if (matchValue(arg, "--cache-policy", value))
+		{
+			auto policy = llvm::parseCachePruningPolicy(value);
+			if (!policy)
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid cache policy '%s': %s", value.c_str(), llvm::toString(policy.takeError()).c_str());
+				return false;
+			}
+			options.cachePolicy = value;
+		}
+		else if (arg == "--cache-stats")
+			options.cacheStats = true;
+		else if (arg == "--use-daemon")
+			options.useDaemon = true;
+		else if (matchValue(arg, "--socket", value))
+			options.socketPath = value;
+		else if (matchValue(arg, "--shards", value))
+		{
+			char* end = nullptr;
+			unsigned long shards = std::strtoul(value.c_str(), &end, 10);
+			if (value.empty() || *end != '\0' || shards > 1024)
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid shard count '%s'", value.c_str());
+				return false;
+			}
+			options.codegenShards = shards == 0 ? llvm::hardware_concurrency().compute_thread_count() : static_cast<unsigned>(shards);
+		}
+		else if (matchValue(arg, "--bench-size", value) || matchValue(arg, "--bench-runs", value))
+		{
+			char* end = nullptr;
+			unsigned long count = std::strtoul(value.c_str(), &end, 10);
+			if (value.empty() || *end != '\0' || count == 0 || count > 100'000'000)
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid count in '%s'", argv[i]);
+				return false;
+			}
+			if (arg.compare(0, 12, "--bench-size") == 0)
+				options.benchSize = static_cast<unsigned>(count);
+			else
+				options.benchRuns = static_cast<unsigned>(count);
+		}
+		else if (matchValue(arg, "--const-eval-steps", value) || matchValue(arg, "--const-eval-memory", value))
+		{
+			char* end = nullptr;
+			unsigned long long limit = std::strtoull(value.c_str(), &end, 10);
+			if (value.empty() || *end != '\0' || limit == 0)
+			{
+				Logger::fmtLog(LogLevel::Error, "Invalid limit in '%s'", argv[i]);
+				return false;
+			}
+			if (arg.compare(0, 18, "--const-eval-steps") == 0)
+				options.constEvalSteps = limit;
+			else
+				options.constEvalMemory = limit;
+		}
+		else if (arg.size() > 1 && arg[0] == '-')
+		{
+			Logger::fmtLog(LogLevel::Error, "Unknown option '%s'", argv[i]);
+			return false;
+		}
+		else
+			options.inputPaths.emplace_back(arg);
+	}
+
+	if (options.bench)
+	{
+		if (!options.outputPath.empty() && !options.inputPaths.empty())
+		{
+			Logger::fmtLog(LogLevel::Error, "bench writes its generated program to '-o', it takes no input files then");
+			return false;
+		}
+		return true;
+	}
+	if (options.inputPaths.size() > 1)
+	{
+		if (options.run)
+		{
+			Logger::fmtLog(LogLevel::Error, "run takes a single file, found %zu", options.inputPaths.size());
+			return false;
+		}
+		if (!options.outputPath.empty() && options.emit != EmitKind::Executable)
+		{
+			Logger::fmtLog(LogLevel::Error, "'-o' cannot name the output of several files unless they are linked with --emit=exe");
+			return false;
+		}
+	}
+	if (options.daemon && !options.inputPaths.empty())
+	{
+		Logger::fmtLog(LogLevel::Error, "The daemon takes no input files, they are sent by 'veritas --use-daemon'");
+		return false;
+	}
+	return true;
+}
+
+void PrintUsage()
+{
+	Logger::Log(LogLevel::None,
+		"Usage: veritas [options] <file>...\n"
+		"       veritas run [options] <file> [-- <program arguments>]\n"
+		"       veritas daemon [-j <n>] [--socket=<path>]\n"
+		"       veritas bench parse|expr|keywords [--bench-size=<n>] [--bench-runs=<n>] [-o <file>] [<file>...]\n"
+		"Options:\n"
+		"  -h, --help                 Show this message\n"
+		"  -O0, -O1, -O2, -O3, -Os, -Oz\n"
+		"                             Optimization level, -O0 (the default) runs no optimizations\n"
+		"  -o <file>                  Output file, with several input files only for --emit=exe\n"
+		"  -j <n>                     Compile n files at the same time, 0 (the default) uses every core\n"
+		"  --emit=llvm|bc|asm|obj|exe Textual IR (the default), bitcode, assembly, an object file or a linked executable\n"
+		"  --print-ir                 Print the final module to stdout\n"
+		"  --lazy                     With run, compile each function on its first call\n"
+		"  --target=<triple>          Target triple, defaults to the host\n"
+		"  -march=<arch>              Target architecture, e.g. x86-64 or aarch64\n"
+		"  -mcpu=<cpu>                Target CPU, 'native' uses the host CPU and its features\n"
+		"  -mattr=<+f1,-f2,...>       Enable or disable target features\n"
+		"  --linker=<program>         Linker driver used for --emit=exe (default: cc, clang on Windows)\n"
+		"  --cache-dir=<dir>          Reuse the outputs of unchanged files from this directory\n"
+		"  --cache-policy=<policy>    Cache eviction, e.g. cache_size_bytes=2g:prune_after=48h (default: 1g)\n"
+		"  --cache-stats              Print cache hits, misses and size to stderr\n"
+		"  --use-daemon               Compile in a running veritas daemon, in-process when there is none\n"
+		"  --socket=<path>            Socket of the daemon (default: $XDG_RUNTIME_DIR/veritasd.sock)\n"
+		"  --shards=<n>               Split functions over n modules compiled in parallel, 0 uses every core\n"
+		"  --const-eval-steps=<n>     Steps a single const may take to evaluate (default: 10000000)\n"
+		"  --const-eval-memory=<n>    Bytes a single const may use while evaluating (default: 64 MiB)\n"
+		"  --verify-each              Verify the module after every optimization pass\n"
+		"  --time-report[=text|json]  Print time, memory and allocations of every compile phase to stderr\n"
+		"Benchmarks:\n"
+		"  parse                      Tokens per second of the tokenizer and parser on the files, or on a generated program\n"
+		"  expr                       The same as parse, the generated program is made of long nested expressions\n"
+		"  keywords                   Nanoseconds per word of classifyWord and of the keyword maps it replaced\n"
+		"  --bench-size=<n>           Functions of the generated program (default: 20000)\n"
+		"  --bench-runs=<n>           Report the best of n runs (default: 5)\n"
+		"  -o <file>                  Write the generated program to file instead of measuring it\n");
+}
+
+std::string getOutputPath(const CompileOptions& options, const std::string& inputPath)
+{
+	if (!options.outputPath.empty())
+		return options.outputPath;
+
+	std::filesystem::path path = std::filesystem::path(inputPath).filename();
+	switch (options.emit)
+	{
+	case EmitKind::LLVM:
+		path.replace_extension(".ll");
+		break;
+	case EmitKind::Bitcode:
+		path.replace_extension(".bc");
+		break;
+	case EmitKind::Assembly:
+		path.replace_extension(".s");
+		break;
+	case EmitKind::Object:
+#ifdef _WIN32
+		path.replace_extension(".obj");
+#else
+		path.replace_extension(".o");
+#endif
+		break;
+	case EmitKind::Executable:
+#ifdef _WIN32
+		path.replace_extension(".exe");
+#else
+		path.replace_extension("");
+		// Never write the executable over an input without extension
+		if (path == std::filesystem::path(inputPath).filename())
+			path += ".out";
+#endif
+		break;
+	}
+	return path.string();
+}
+
+std::string resolvePath(const CompileOptions& options, const std::string& path)
+{
+	if (options.workingDirectory.empty() || path.empty() || std::filesystem::path(path).is_absolute())
+		return path;
+	return (std::filesystem::path(options.workingDirectory) / path).string();
+}
@@ -1,119 +1,206 @@
 #include "headers/Parser.h"
 
+#include <array>
+#include <cstdint>
+
 #define RUN_AND_RETURN(cmd, exitValue) { cmd; return exitValue;}
 
-Parser::Parser(std::vector<Token>& tokens) 
+// Binding power of each binary operator, higher binds tighter. 0 means the token ends the expression
+static constexpr std::array<uint8_t, TokenType::_EOF + 1> g_binaryPrecedence = [] {
+	std::array<uint8_t, TokenType::_EOF + 1> table{};
+	table[TokenType::EQUALITY] = 10;
+	table[TokenType::NOT_EQUAL] = 10;
+	table[TokenType::LESS_THAN] = 11;
+	table[TokenType::LESS_EQUAL] = 11;
+	table[TokenType::GREATER_THAN] = 11;
+	table[TokenType::GREATER_EQUAL] = 11;
+	table[TokenType::PLUS] = 12;
+	table[TokenType::MINUS] = 12;
+	table[TokenType::STAR] = 13;
+	table[TokenType::FORWARD_SLASH] = 13;
+	table[TokenType::MODULUS] = 13;
+	return table;
+}();
+
+static_assert(g_binaryPrecedence[TokenType::STAR] > g_binaryPrecedence[TokenType::PLUS]);
+static_assert(g_binaryPrecedence[TokenType::SEMICOLON] == 0);
+
+// Parentheses, indices, unary operators and call arguments recurse, past this depth the
+// expression is rejected instead of running out of stack
+static constexpr size_t MAX_EXPR_DEPTH = 256;
+
+Parser::Parser(TokenStream& tokens) 
 	: m_tokens(std::move(tokens)), m_programAST(std::make_unique<Program>())
 {
-	OperandTuple[TokenType::PLUS]	  = { 12, 'L' };
-	OperandTuple[TokenType::MINUS] = { 12, 'L' };
-	OperandTuple[TokenType::STAR] = { 13, 'L' };
-	OperandTuple[TokenType::FORWARD_SLASH] = { 13, 'L' };
-	OperandTuple[TokenType::MODULUS]  = { 13, 'L' };
+	m_arena = &m_programAST->arena;
 }
 
 bool Parser::Parse()
 {
-	while(peek().has_value() && peek().value().type != TokenType::_EOF)
+	while(peekType() != TokenType::_EOF)
 	{
-		switch (peek().value().type)
+		uint8_t attributes = 0;
+		if (peekType() == TokenType::IDENT && !ParseFnAttributes(attributes))
+			return false;
+		if (attributes != 0 && peekType() != TokenType::FN && !(peekType() == TokenType::CONST && peekType(1) == TokenType::FN))
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected 'fn' after the function attributes on line: %ld", getLine()), false)
+
+		switch (peekType())
 		{
 		case TokenType::FN:
 		{
-			auto fn = std::move(ParseFunction());
-			if (fn.get() != NULL)
-				m_programAST->FnStmts.push_back(std::move(fn));
-			else 
+			FnStmt* fn = ParseFunction();
+			if (fn == nullptr)
 				return false;
+			fn->attributes = attributes;
+			if (!CheckFnAttributes(fn))
+				return false;
+			m_programAST->FnStmts.push_back(fn);
 			break;
 		}
 		case TokenType::LET:
 			if (!ParseGlobalDecl())
 				return false;
 			break;
+		case TokenType::CONST:
+			if (peekType(1) == TokenType::FN)
+			{
+				consume(/* Consume the CONST Token */);
+				FnStmt* fn = ParseFunction();
+				if (fn == nullptr)
+					return false;
+				if (fn->isExtern || fn->compoundStmt == nullptr)
+					RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A const fn cannot be extern and needs a body, line: %ld", getLine(-1)), false);
+				fn->isConst = true;
+				fn->attributes = attributes;
+				if (!CheckFnAttributes(fn))
+					return false;
+				m_programAST->FnStmts.push_back(fn);
+			}
+			else if (!ParseGlobalDecl())
+				return false;
+			break;
 		default:
-			Logger::fmtLog(Error, "Expected a declaration on line: %ld", peek().value().lineNum);
+			Logger::fmtLog(Error, "Expected a declaration on line: %ld", getLine());
 			return false;
 		}
 	}
 	return true;
 }
 
+bool Parser::ParseFnAttributes(uint8_t& attributes)
+{
+	while (const Token* token = PeekAndCheck(TokenType::IDENT))
+	{
+		std::string_view word = m_tokens.getText(*token);
+		uint8_t attribute = 0;
+		if (word == "inline")
+			attribute = FN_INLINE;
+		else if (word == "noinline")
+			attribute = FN_NOINLINE;
+		else if (word == "pure")
+			attribute = FN_PURE;
+		else if (word == "cold")
+			attribute = FN_COLD;
+		else if (word == "hot")
+			attribute = FN_HOT;
+		else
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unknown function attribute '%.*s' on line: %ld", (int)word.size(), word.data(), getLine()), false)
+
+		if (attributes & attribute)
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Function attribute '%.*s' is repeated on line: %ld", (int)word.size(), word.data(), getLine()), false)
+		attributes |= attribute;
+		consume();
+	}
+	return true;
+}
+
+bool Parser::CheckFnAttributes(const FnStmt* fnStmt)
+{
+	uint8_t attributes = fnStmt->attributes;
+	if ((attributes & FN_INLINE) && (attributes & FN_NOINLINE))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A function cannot be both inline and noinline, line: %ld", getLine(-1)), false)
+	if ((attributes & FN_HOT) && (attributes & FN_COLD))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A function cannot be both hot and cold, line: %ld", getLine(-1)), false)
+	if ((attributes & FN_INLINE) && fnStmt->compoundStmt == nullptr)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "An inline function needs a body, line: %ld", getLine(-1)), false)
+	return true;
+}
+
 bool Parser::ParseGlobalDecl()
 {
-	std::unique_ptr<DeclStmt> stmt = std::make_unique<DeclStmt>();
-	consume(/* Consume the LET Token */);
+	DeclStmt* stmt = m_arena->New<DeclStmt>();
+	stmt->isConst = consume(/* Consume the LET or CONST Token */).type == TokenType::CONST;
 
 	if (PeekAndCheck(TokenType::IDENT))
-		stmt->IDENT = consume().value;
+		stmt->IDENT = consume().symbol;
 	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected identifier on line: %ld", peek(-1).value().lineNum), false)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected identifier on line: %ld", getLine(-1)), false)
 
-	if (!PeekAndCheck(TokenType::COLON))
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected ':' on line: %ld", peek(-1).value().lineNum), false)
-	else consume();
+	if (!match(TokenType::COLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected ':' on line: %ld", getLine(-1)), false)
 
-	if (PeekAndCheck(TokenType::BuiltinType))
-		stmt->type = consume().dataType;
-	else 
-		RUN_AND_RETURN(Logger::fmtLog("Expected variable type on line: %ld", peek(-1).value().lineNum), false)
+	if (!ParseDeclType(stmt))
+		return false;
+	if (stmt->isConst && stmt->arrayLength != 0)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A const cannot be an array, line: %ld", getLine(-1)), false)
 
-	if (PeekAndCheck(TokenType::EQUALS))
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Warning, "Expression declaration not implemented!"), false)
-	else consume();
+	// Without an initializer the global starts out zeroed
+	if (stmt->arrayLength != 0 && PeekAndCheck(TokenType::EQUALS))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "An array cannot have an initializer, it starts out zeroed, line: %ld", getLine()), false)
+	if (match(TokenType::EQUALS))
+	{
+		stmt->expr = ParseExpr();
+		if (stmt->expr == nullptr)
+			return false;
+	}
+	else if (stmt->isConst)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A const needs a value on line: %ld", getLine(-1)), false)
 
-	if (!PeekAndCheck(TokenType::SEMICOLON))
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected ';' at the end of declaration on line: %ld", peek(-1).value().lineNum), false)
-	else consume();
+	if (!match(TokenType::SEMICOLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected ';' at the end of declaration on line: %ld", getLine(-1)), false)
 
-	m_programAST->DeclStmts.push_back(std::move(stmt));
+	m_programAST->DeclStmts.push_back(stmt);
 	return true;
 }
 
-std::unique_ptr<FnStmt> Parser::ParseFunction()
+FnStmt* Parser::ParseFunction()
 {
-	std::unique_ptr<FnStmt> fnStmt = std::make_unique<FnStmt>();
+	FnStmt* fnStmt = m_arena->New<FnStmt>();
 	consume(/*Consume the fn keyword*/);
 	
-	if (PeekAndCheck(TokenType::EXTERN))
-	{
-		consume();
+	if (match(TokenType::EXTERN))
 		fnStmt->isExtern = true;
-	}
 
 	if (PeekAndCheck(TokenType::IDENT))
-		fnStmt->name = consume().value;
+		fnStmt->name = consume().symbol;
 	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected function name on line: %ld", peek(-1).value().lineNum), NULL);
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected function name on line: %ld", getLine(-1)), NULL);
 
-	if (PeekAndCheck(TokenType::LParan))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected '(' on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::LParan))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected '(' on line: %ld", getLine(-1)), NULL);
 	
-	while (peek().has_value() && peek().value().type != TokenType::RParan)
+	size_t paramsStart = m_paramScratch.size();
+	while (peekType() != TokenType::RParan)
 	{
-		auto res = ParseParamDecl();
-		if (res.get() != NULL)
-			fnStmt->params.emplace_back(std::move(res));
+		ParamDecl* res = ParseParamDecl();
+		if (res != nullptr)
+			m_paramScratch.push_back(res);
 		else
 			return NULL;
 	}
+	fnStmt->params = m_arena->TakeTail(m_paramScratch, paramsStart);
 	
-	if (PeekAndCheck(TokenType::RParan))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected ')' on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::RParan))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected ')' on line: %ld", getLine(-1)), NULL);
 
-	if (PeekAndCheck(TokenType::ARROW))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected '->' on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::ARROW))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected '->' on line: %ld", getLine(-1)), NULL);
 
 	if (PeekAndCheck(TokenType::BuiltinType))
 		fnStmt->returnType = consume().dataType;
 	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected function return type on line: %ld", peek(-1).value().lineNum), NULL);
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error,"Expected function return type on line: %ld", getLine(-1)), NULL);
 
 	if (PeekAndCheck(TokenType::SEMICOLON))
 	{
@@ -121,149 +208,227 @@ std::unique_ptr<FnStmt> Parser::ParseFunction()
 		return fnStmt;
 	}
 
-	auto compoundStmt = ParseCompoundStmt();
-	if (compoundStmt.get() != NULL)
-		fnStmt->compoundStmt = std::move(compoundStmt);
+	CompoundStmt* compoundStmt = ParseCompoundStmt();
+	if (compoundStmt != nullptr)
+		fnStmt->compoundStmt = compoundStmt;
 	else 
 		return NULL;
 
 	return fnStmt;
 }
 
-std::unique_ptr<ParamDecl> Parser::ParseParamDecl()
+ParamDecl* Parser::ParseParamDecl()
 {
 	/*
 	*	Grammar:
 	*		Param: ident ':' Type <','>? || '...' <','>?
 	*/
 
-	auto param = std::make_unique<ParamDecl>();
+	ParamDecl* param = m_arena->New<ParamDecl>();
 	
-	if (PeekAndCheck(TokenType::ELLIPSIS))
+	if (match(TokenType::ELLIPSIS))
 	{
 		param->VarArg = true;
-		consume();
 	}
 
 	else if (PeekAndCheck(TokenType::IDENT))
 	{
-		param->ident = consume().value;
+		param->ident = consume().symbol;
 
-		if (PeekAndCheck(TokenType::COLON))
-			consume();
-		else
+		if (!match(TokenType::COLON))
 		{
-			Logger::fmtLog(LogLevel::Error, "Missing a ':' after identifier on line: %ld", peek(-1).value().lineNum);
+			Logger::fmtLog(LogLevel::Error, "Missing a ':' after identifier on line: %ld", getLine(-1));
 			return nullptr;
 		}
+		if (!ParseParamQualifiers(param))
+			return nullptr;
 
-		if (PeekAndCheck(TokenType::BuiltinType)) 
+		bool isPointer = false;
+		if (match(TokenType::LSQUARE))
+		{
+			// Slice: [type]
+			param->isSlice = true;
+			if (PeekAndCheck(TokenType::BuiltinType))
+				param->type = consume().dataType;
+			if (param->type == PrimitiveDataType::EMPTY || param->type == PrimitiveDataType::VOID || !match(TokenType::RSQUARE))
+			{
+				Logger::fmtLog(LogLevel::Error, "Expected a slice '[type]' on line: %ld", getLine(-1));
+				return nullptr;
+			}
+		}
+		else if (PeekAndCheck(TokenType::BuiltinType)) 
 		{
 			param->type = consume().dataType;
-			if (PeekAndCheck(TokenType::STAR))
+			if (match(TokenType::STAR))
 			{
-				consume();
-
 				PrimitiveDataType PtrType = ptrTypeof(param->type);
 				if (PtrType == PrimitiveDataType::EMPTY)
 				{
-					Logger::fmtLog(LogLevel::Error, "Pointer to invalid type on line: %ld", peek(-1).value().lineNum);
+					Logger::fmtLog(LogLevel::Error, "Pointer to invalid type on line: %ld", getLine(-1));
 					return nullptr;
 				}
 				param->type = PtrType;
+				isPointer = true;
 			}
 		}
 		else
 		{
-			Logger::fmtLog(LogLevel::Error, "Expected type of parameter on line: %ld", peek(-1).value().lineNum);
+			Logger::fmtLog(LogLevel::Error, "Expected type of parameter on line: %ld", getLine(-1));
+			return nullptr;
+		}
+		if ((param->isRestrict || param->alignment != 0) && !isPointer && !param->isSlice)
+		{
+			Logger::fmtLog(LogLevel::Error, "restrict and align only apply to pointer and slice parameters, line: %ld", getLine(-1));
 			return nullptr;
 		}
 
-		if (PeekAndCheck(TokenType::COMMA))
-			consume();
+		match(TokenType::COMMA);
 	}
 	else {
-		Logger::fmtLog(LogLevel::Error, "Unknown token found on line: %ld", peek(-1).value().lineNum);
+		Logger::fmtLog(LogLevel::Error, "Unknown token found on line: %ld", getLine(-1));
 		return nullptr;
 	}
 
 	return param;
 }
 
-std::unique_ptr<CompoundStmt> Parser::ParseCompoundStmt()
+bool Parser::ParseParamQualifiers(ParamDecl* param)
 {
-	std::unique_ptr<CompoundStmt> CStmt = std::make_unique<CompoundStmt>();
+	// Like function attributes these are plain words, they only mean something in front of a type
+	while (const Token* token = PeekAndCheck(TokenType::IDENT))
+	{
+		std::string_view word = m_tokens.getText(*token);
+		if (word == "restrict" && !param->isRestrict)
+		{
+			consume();
+			param->isRestrict = true;
+		}
+		else if (word == "align" && param->alignment == 0)
+		{
+			consume();
+			// Powers of two up to a page, what an allocation can be asked for
+			uint64_t alignment = 0;
+			if (match(TokenType::LParan) && PeekAndCheck(TokenType::INT_LITERAL))
+			{
+				for (char digit : m_tokens.getText(consume()))
+				{
+					alignment = alignment * 10 + (digit - '0');
+					if (alignment > 4096)
+						break;
+				}
+			}
+			if (alignment == 0 || alignment > 4096 || (alignment & (alignment - 1)) != 0 || !match(TokenType::RParan))
+				RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected 'align(N)' with N a power of two up to 4096 on line: %ld", getLine(-1)), false)
+			param->alignment = (uint32_t)alignment;
+		}
+		else
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unknown or repeated parameter qualifier '%.*s' on line: %ld", (int)word.size(), word.data(), getLine()), false)
+	}
+	return true;
+}
 
-	if (PeekAndCheck(TokenType::LCURLY))
-		consume();
-	else RUN_AND_RETURN(Logger::fmtLog("Expected '{' on line: %ld", peek(-1).value().lineNum), NULL);
+CompoundStmt* Parser::ParseCompoundStmt()
+{
+	CompoundStmt* CStmt = m_arena->New<CompoundStmt>();
+
+	if (!match(TokenType::LCURLY))
+		RUN_AND_RETURN(Logger::fmtLog("Expected '{' on line: %ld", getLine(-1)), NULL);
 
-	while (peek().has_value() && peek().value().type != TokenType::RCURLY)
+	// Nested compound statements share the scratch vector, each takes back only its own tail
+	size_t listStart = m_stmtScratch.size();
+	while (peekType() != TokenType::RCURLY)
 	{
-		auto stmt = std::move(ParseStmt());
-		if (stmt.get() != NULL)
-			CStmt->statementList.push_back(std::move(stmt));
+		Stmt* stmt = ParseStmt();
+		if (stmt != nullptr)
+			m_stmtScratch.push_back(stmt);
 		else 
 			return NULL;
 	}
+	CStmt->statementList = m_arena->TakeTail(m_stmtScratch, listStart);
 
-	if (PeekAndCheck(TokenType::RCURLY))
-		consume();
-	else RUN_AND_RETURN(Logger::fmtLog("Expected '}' on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::RCURLY))
+		RUN_AND_RETURN(Logger::fmtLog("Expected '}' on line: %ld", getLine(-1)), NULL);
 
 	return CStmt;
 }
 
-std::unique_ptr<Stmt> Parser::ParseStmt()
+Stmt* Parser::ParseStmt()
 {
-	std::unique_ptr<Stmt> Statement = std::make_unique<Stmt>();
+	Stmt* Statement = m_arena->New<Stmt>();
 	/*TODO: PLUS other stmt parsing*/
 
-	if (peek().has_value())
+	if (peek() != nullptr)
 	{
-		switch (peek().value().type)
+		switch (peekType())
 		{
 			case TokenType::RETURN:
 			{
-				auto retStmt = ParseReturnStmt();
-				if (retStmt.get() != NULL)
-					Statement->stmt = std::move(retStmt);
+				ReturnStmt* retStmt = ParseReturnStmt();
+				if (retStmt != nullptr)
+					Statement->stmt = retStmt;
+				else
+					return nullptr;
+			}
+			break;
+			case TokenType::LCURLY:
+			{
+				// A nested block, its declarations end with it
+				CompoundStmt* compoundStmt = ParseCompoundStmt();
+				if (compoundStmt != nullptr)
+					Statement->stmt = compoundStmt;
 				else
 					return nullptr;
 			}
 			break;
 			case TokenType::LET:
+			case TokenType::CONST:
+			{
+				DeclStmt* declStmt = ParseDeclStmt();
+				if (declStmt != nullptr)
+					Statement->stmt = declStmt;
+				else
+					return nullptr;
+			}
+			break;
+			case TokenType::FOR:
 			{
-				auto declStmt = ParseDeclStmt();
-				if (declStmt.get() != NULL)
-					Statement->stmt = std::move(declStmt);
+				ForStmt* forStmt = ParseForStmt();
+				if (forStmt != nullptr)
+					Statement->stmt = forStmt;
 				else
 					return nullptr;
 			}
 			break;
 			case TokenType::IDENT:
 			{
-				if(peek(1).has_value())
+				if (peek(1) != nullptr)
 				{
-					if (peek(1).value().type == TokenType::LParan)
+					if (peekType(1) == TokenType::LParan)
 					{
 						// Function call
-						auto fnCall = ParseFunctionCallStmt(/*IDENT & '(' is not consumed*/);
-						if (fnCall.get() != nullptr)
-							Statement->stmt = std::move(fnCall);
+						FnCall* fnCall = ParseFunctionCallStmt(/*IDENT & '(' is not consumed*/);
+						if (fnCall != nullptr)
+							Statement->stmt = fnCall;
 						else
 							return nullptr;
 					}
-					else if (peek(1).value().type == TokenType::EQUALS)
+					else if (peekType(1) == TokenType::EQUALS || peekType(1) == TokenType::LSQUARE)
 					{
-						Logger::fmtLog("Not implemented (\nFile:%s, line: %ld)!", __FILE__, __LINE__);
-						return nullptr;
+						AssignStmt* assignStmt = ParseAssignStmt();
+						if (assignStmt != nullptr)
+							Statement->stmt = assignStmt;
+						else
+							return nullptr;
 					}
+					else
+						RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unexpected statement on line: %ld", getLine()), nullptr);
 				}
+				else
+					RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unexpected end of file after line: %ld", getLine()), nullptr);
 			}
 			break;
 			default:
-				Logger::fmtLog(LogLevel::Error, "Unexpected statement on line: %ld", peek(-1).value().lineNum);
+				Logger::fmtLog(LogLevel::Error, "Unexpected statement on line: %ld", getLine(-1));
 				return nullptr;
 		}
 	}
@@ -271,352 +436,389 @@ std::unique_ptr<Stmt> Parser::ParseStmt()
 	return Statement;
 }
 
-std::unique_ptr<DeclStmt> Parser::ParseDeclStmt()
+DeclStmt* Parser::ParseDeclStmt()
 {
-	auto declStmt = std::make_unique<DeclStmt>();
-	consume(/*LET Token*/);
+	DeclStmt* declStmt = m_arena->New<DeclStmt>();
+	declStmt->isConst = consume(/*LET or CONST Token*/).type == TokenType::CONST;
 	
 	if (PeekAndCheck(TokenType::IDENT))
-		declStmt->IDENT = consume().value;
+		declStmt->IDENT = consume().symbol;
 	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an identifier after let on line: %ld", peek(-1).value().lineNum), NULL);
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an identifier after let on line: %ld", getLine(-1)), NULL);
 	
-	if (PeekAndCheck(TokenType::COLON))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an ':' after identifier on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::COLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an ':' after identifier on line: %ld", getLine(-1)), NULL);
 	
-	if (PeekAndCheck(TokenType::BuiltinType))
-		declStmt->type = consume().dataType;
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an type on line: %ld", peek(-1).value().lineNum), NULL);
+	if (!ParseDeclType(declStmt))
+		return NULL;
 
-	if (PeekAndCheck(TokenType::EQUALS))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an '=' on line: %ld", peek(-1).value().lineNum), NULL);
+	if (declStmt->arrayLength != 0)
+	{
+		if (declStmt->isConst)
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "A const cannot be an array, line: %ld", getLine(-1)), NULL);
+		if (!match(TokenType::SEMICOLON))
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "An array cannot have an initializer, it starts out zeroed, line: %ld", getLine(-1)), NULL);
+		return declStmt;
+	}
+
+	if (!match(TokenType::EQUALS))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an '=' on line: %ld", getLine(-1)), NULL);
 	
 	/*EXPRESSION PARSING*/
-	auto ExprTree = ParseExpr();
-	if (ExprTree.get() == NULL)
+	Expr* ExprTree = ParseExpr();
+	if (ExprTree == nullptr)
 		return NULL;
 
-	if (PeekAndCheck(TokenType::SEMICOLON))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing ';' at the end of line: %ld", peek(-1).value().lineNum), NULL);
+	if (!match(TokenType::SEMICOLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing ';' at the end of line: %ld", getLine(-1)), NULL);
 	
-	declStmt->expr = std::move(ExprTree);
+	declStmt->expr = ExprTree;
 	return declStmt;
 }
 
-std::unique_ptr<ReturnStmt> Parser::ParseReturnStmt()
+bool Parser::ParseDeclType(DeclStmt* declStmt)
 {
-	auto retStmt = std::make_unique<ReturnStmt>();
-	consume(/*Return Token*/);
-	
-	auto ExprTree = ParseExpr();
-	if (ExprTree.get() == NULL)
-		return NULL;
+	/*
+	*	Grammar:
+	*		Type: BuiltinType || '[' BuiltinType ';' INT_LITERAL ']'
+	*/
 
-	if (PeekAndCheck(TokenType::SEMICOLON))
-		consume();
+	bool isArray = match(TokenType::LSQUARE);
+	if (PeekAndCheck(TokenType::BuiltinType))
+		declStmt->type = consume().dataType;
 	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing ';' at the end of line: %ld", peek(-1).value().lineNum), NULL);
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an type on line: %ld", getLine(-1)), false);
+	if (!isArray)
+		return true;
 
-	retStmt->value = std::move(ExprTree);
-	return retStmt;
+	if (declStmt->type == PrimitiveDataType::VOID || !match(TokenType::SEMICOLON) || !PeekAndCheck(TokenType::INT_LITERAL))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an array '[type; length]' on line: %ld", getLine(-1)), false);
+
+	std::string_view text = m_tokens.getText(consume());
+	uint64_t length = 0;
+	for (char digit : text)
+	{
+		length = length * 10 + (digit - '0');
+		if (length > UINT32_MAX)
+			break;
+	}
+	if (length == 0 || length > UINT32_MAX)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Array length must be between 1 and %u on line: %ld", UINT32_MAX, getLine(-1)), false);
+	declStmt->arrayLength = static_cast<uint32_t>(length);
+
+	if (!match(TokenType::RSQUARE))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ']' on line: %ld", getLine(-1)), false);
+	return true;
 }
 
-std::unique_ptr<Expr> Parser::ParseFunctionCallExpr()
+ForStmt* Parser::ParseForStmt()
 {
-	auto expr = std::make_unique<Expr>();
-	auto fnCall = std::make_unique<FnCall>();
-	
-	fnCall->name = consume(/* TOKEN: IDENT */).value;
+	/*
+	*	Grammar:
+	*		For: 'for' IDENT 'in' Expr '..' Expr CompoundStmt
+	*/
 
-	//No need to consume as parsing args list will do automatically
-	//consume(/* TOKEN: LParan */);
+	ForStmt* forStmt = m_arena->New<ForStmt>();
+	consume(/* FOR Token */);
 
-	if (peek().has_value() && peek().value().type == TokenType::RParan)
-	{
-		consume(/*TOKEN: LParan*/);
-		expr->value = std::move(fnCall);
-		return expr;
-	}
+	if (PeekAndCheck(TokenType::IDENT))
+		forStmt->ident = consume().symbol;
 	else
-	{
-		fnCall->args = ParseArgsList();
-		if (fnCall->args.get() == nullptr)
-			return nullptr;
-	}
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected the loop variable after for on line: %ld", getLine(-1)), NULL);
 
-	expr->value = std::move(fnCall);
-	return expr;
+	if (!match(TokenType::IN))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected 'in' on line: %ld", getLine(-1)), NULL);
+
+	// '..' binds looser than every operator, so it ends the first expression
+	forStmt->start = ParseExpr();
+	if (forStmt->start == nullptr)
+		return NULL;
+
+	if (!match(TokenType::DOT_DOT))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a range 'start..end' on line: %ld", getLine(-1)), NULL);
+
+	forStmt->end = ParseExpr();
+	if (forStmt->end == nullptr)
+		return NULL;
+
+	forStmt->body = ParseCompoundStmt();
+	if (forStmt->body == nullptr)
+		return NULL;
+	return forStmt;
 }
 
-std::unique_ptr<FnCall> Parser::ParseFunctionCallStmt(/* IDENT & LParan is not consumed */)
+AssignStmt* Parser::ParseAssignStmt()
 {
-	auto fnCall = std::make_unique<FnCall>();
-	fnCall->name = consume(/* TOKEN: IDENT */).value;
-	//No need to consume as parsing args list will do automatically
-	// consume(/* TOKEN: LParan */); 
-	
-	if (peek().has_value() && peek().value().type == TokenType::RParan) {
-		consume(/* TOKEN: LParan */);
-		return fnCall;
-	}
-	else
+	AssignStmt* assignStmt = m_arena->New<AssignStmt>();
+	assignStmt->ident = consume(/* TOKEN: IDENT */).symbol;
+	if (match(TokenType::LSQUARE))
 	{
-		fnCall->args = ParseArgsList();
-		if (fnCall->args.get() == nullptr)
-			return nullptr;
+		assignStmt->index = ParseExpr();
+		if (assignStmt->index == nullptr)
+			return NULL;
+		if (!match(TokenType::RSQUARE))
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ']' on line: %ld", getLine(-1)), NULL);
 	}
-	if (PeekAndCheck(TokenType::SEMICOLON))
-		consume();
-	else
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ';' at line: %ld", peek(-1).value().lineNum), nullptr);
-	
-	return fnCall;
+	if (!match(TokenType::EQUALS))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected an '=' on line: %ld", getLine(-1)), NULL);
+
+	Expr* ExprTree = ParseExpr();
+	if (ExprTree == nullptr)
+		return NULL;
+
+	if (!match(TokenType::SEMICOLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing ';' at the end of line: %ld", getLine(-1)), NULL);
+
+	assignStmt->value = ExprTree;
+	return assignStmt;
 }
 
-std::unique_ptr<ArgsList> Parser::ParseArgsList()
+ReturnStmt* Parser::ParseReturnStmt()
 {
-	auto argsList = std::make_unique<ArgsList>();
-	// Push the LParen of function call
-	m_operatorStack.push(consume(/*LParen Token*/));
+	ReturnStmt* retStmt = m_arena->New<ReturnStmt>();
+	consume(/*Return Token*/);
+	if (match(TokenType::SEMICOLON))
+		return retStmt;
+	
+	Expr* ExprTree = ParseExpr();
+	if (ExprTree == nullptr)
+		return NULL;
 
-	while (peek().has_value() && (peek().value().type != TokenType::RParan || m_operatorStack.size() != 0)) {
-		// Now individual argument needs to be parsed
+	if (!match(TokenType::SEMICOLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing ';' at the end of line: %ld", getLine(-1)), NULL);
 
-		while (peek().has_value() && peek().value().type != TokenType::COMMA) {
+	retStmt->value = ExprTree;
+	return retStmt;
+}
 
-			switch (peek().value().type)
-			{
-			case TokenType::INT_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::i32)));
-				break;
-			case TokenType::FLOAT_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::f64)));
-				break;
-			case TokenType::STRING_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::str)));
-				break;
-			case TokenType::IDENT:
-				if (peek(1).has_value() && peek(1).value().type == TokenType::LParan)
-				{
-					m_nodeStack.push(std::move(ParseFunctionCallExpr()));
-				}
-				else
-				{
-					// This is a case where the ident is a variable
-					m_nodeStack.push(std::move(CreateVarExpr(consume().value)));
-				}
-				break;
-			case TokenType::LParan:
-				m_operatorStack.push(consume());
-				break;
+bool Parser::ParseFunctionCallExpr(uint32_t& result)
+{
+	FnCall* fnCall = m_arena->New<FnCall>();
+	fnCall->name = consume(/* TOKEN: IDENT */).symbol;
+
+	// Arguments nest like parentheses, f(f(f(...))) is bounded by the same depth
+	m_exprDepth++;
+	fnCall->args = ParseArgsList();
+	m_exprDepth--;
+	if (fnCall->args == nullptr)
+		return false;
 
-			case TokenType::RParan:
-			{
-				consume();
-				while (!m_operatorStack.empty() && m_operatorStack.top().type != TokenType::LParan) {
-					if (!ApplyOperator()) {
-						return nullptr;
-					}
-				}
-				if (!m_operatorStack.empty() && m_operatorStack.top().type == TokenType::LParan) {
-						m_operatorStack.pop();
-						if (m_operatorStack.empty()) {
-							// parsing of arg list complete
-							// exit this loop add the current parsed arg into argsList;
-							argsList->list.emplace_back(std::move(m_nodeStack.top()));
-							m_nodeStack.pop();
-							return argsList;
-						}
-				}
-			}
-			break;
-			case TokenType::PLUS:
-			case TokenType::MINUS:
-			case TokenType::FORWARD_SLASH:
-			case TokenType::STAR:
-			case TokenType::MODULUS:
-			{
-				Token curr = consume();
-				while (!m_operatorStack.empty() && (OperandTuple[curr.type].first < OperandTuple[m_operatorStack.top().type].first ||
-					OperandTuple[curr.type].first == OperandTuple[m_operatorStack.top().type].first &&
-					OperandTuple[curr.type].second == 'L'))
-				{
-					if (!ApplyOperator())
-						return nullptr;
-				}
+	result = PushCallNode(fnCall);
+	return true;
+}
 
-				// Push the current operator onto stack
-				m_operatorStack.push(curr);
-			}
-			break;
-			default:
-				RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unexpected token found on line: %lu", peek().value().lineNum), NULL);
-			}
-		}
+FnCall* Parser::ParseFunctionCallStmt(/* IDENT & LParan is not consumed */)
+{
+	FnCall* fnCall = m_arena->New<FnCall>();
+	fnCall->name = consume(/* TOKEN: IDENT */).symbol;
 
-		if(peek().has_value() && peek().value().type == TokenType::COMMA) {
-			consume();
-		}
-		else {
-			Logger::fmtLog(LogLevel::Error, "Missing a ',' after the arguement finished on line: %lu", peek(-1).value().lineNum);
-			return nullptr;
-		}
+	fnCall->args = ParseArgsList();
+	if (fnCall->args == nullptr)
+		return nullptr;
 
-		// Pop all the remaining elements from the stack
-		while (!m_operatorStack.empty()) {
-			if (m_operatorStack.top().type == TokenType::LParan) {
-				if (m_operatorStack.size() > 1) {
-					Logger::fmtLog(LogLevel::Error, "Expected a ')' on line: %lu", peek(-1).value().lineNum);
-					return nullptr;
-				}
-				else break;
-			}
-			else if (!ApplyOperator())
-				return nullptr;
-		}
+	if (!match(TokenType::SEMICOLON))
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ';' at line: %ld", getLine(-1)), nullptr);
+	
+	return fnCall;
+}
 
-		if (m_nodeStack.size() != 1)
-		{
-			Logger::fmtLog(LogLevel::Error, "Mismatched operands and operators in expression!");
+ArgsList* Parser::ParseArgsList()
+{
+	/*
+	*	Grammar:
+	*		ArgsList: '(' (Expr (',' Expr)* ','?)? ')'
+	*/
+
+	ArgsList* argsList = m_arena->New<ArgsList>();
+	// Arguments of calls nested in this one are pushed above argsStart and taken back first
+	size_t argsStart = m_exprScratch.size();
+	consume(/*LParen Token*/);
+
+	while (!match(TokenType::RParan))
+	{
+		Expr* arg = ParseExpr();
+		if (arg == nullptr)
 			return nullptr;
-		}
+		m_exprScratch.push_back(arg);
 
-		argsList->list.emplace_back(std::move(m_nodeStack.top()));
-		m_nodeStack.pop();
+		if (!match(TokenType::COMMA) && peekType() != TokenType::RParan)
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Missing a ',' after the arguement finished on line: %lu", getLine(-1)), nullptr);
 	}
 
+	argsList->list = m_arena->TakeTail(m_exprScratch, argsStart);
 	return argsList;
 }
 
-std::unique_ptr<Expr> Parser::ParseExpr()
+Expr* Parser::ParseExpr()
 {
-	if (m_nodeStack.size() != 0)
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Node stack contains previously added nodes"), nullptr);
-	if (m_operatorStack.size() != 0)
-		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Operator stack is not empty"), nullptr);
+	// Call arguments are expressions of their own and are parsed while the enclosing one is still open
+	size_t outerBase = m_exprBase;
+	m_exprBase = m_exprNodes.size();
 
-	auto mainExpr = std::make_unique<Expr>();
+	uint32_t root;
+	bool ok = ParseBinaryExpr(1, root);
 
-	while (peek().has_value() && peek().value().type != TokenType::SEMICOLON)
+	Expr* expr = nullptr;
+	if (ok)
 	{
-		switch (peek().value().type)
-		{
-			case TokenType::INT_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::i32)));
-				break;
-			case TokenType::FLOAT_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::f64)));
-				break;
-			case TokenType::STRING_LITERAL:
-				m_nodeStack.push(std::move(CreateLiteralExpr(consume().value, PrimitiveDataType::str)));
-				break;
-			case TokenType::IDENT:
-				if (peek(1).has_value() && peek(1).value().type == TokenType::LParan)
-				{
-					m_nodeStack.push(std::move(ParseFunctionCallExpr()));
-				}
-				else
-				{
-					// This is a case where the ident is a variable
-					m_nodeStack.push(std::move(CreateVarExpr(consume().value)));
-				}
-				break;
-			case TokenType::LParan:
-				m_operatorStack.push(consume());
-				break;
-			
-			case TokenType::RParan:
-			{
-				consume(/* Consume '(' */);
-				// If the scanned character is an ), pop form a new binOP with the prev 2 nodes on nodeStack
-				// until an ( is encountered.
-				while (!m_operatorStack.empty() && m_operatorStack.top().type != TokenType::LParan)
-					if (!ApplyOperator(/*Directly accesses Node and Operator Stack*/))
-						return nullptr;
-				if (!m_operatorStack.empty() && m_operatorStack.top().type == TokenType::LParan)
-					m_operatorStack.pop();
-				else
-					RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a '(' on line: %ld!", peek(-1).value().lineNum), nullptr);
-			}
-			break;
-			
-			case TokenType::PLUS:
-			case TokenType::MINUS:
-			case TokenType::FORWARD_SLASH:
-			case TokenType::STAR:
-			case TokenType::MODULUS:
-			{
-				Token curr = consume();
-				while (!m_operatorStack.empty() && (OperandTuple[curr.type].first < OperandTuple[m_operatorStack.top().type].first || 
-					OperandTuple[curr.type].first == OperandTuple[m_operatorStack.top().type].first && 
-					OperandTuple[curr.type].second == 'L'))
-				{
-					if (!ApplyOperator())
-						return nullptr;
-				}
+		// Operands are appended before the nodes using them, so the root is always last
+		expr = m_arena->New<Expr>();
+		expr->nodes = m_arena->TakeTail(m_exprNodes, m_exprBase);
+	}
+	else
+		m_exprNodes.resize(m_exprBase);
 
-				// Push the current operator onto stack
-				m_operatorStack.push(curr);
-			}
-			break;
+	m_exprBase = outerBase;
+	return expr;
+}
 
-			default:
-				RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unexpected token found on line: %lu", peek().value().lineNum), NULL);
-		}
-	}
-	
-	// Pop all the remaining elements from the stack
-	while (!m_operatorStack.empty()) {
-		if (m_operatorStack.top().type == TokenType::LParan) {
-			Logger::fmtLog(LogLevel::Error, "Expected a ')' on line: %lu", m_operatorStack.top().lineNum);
-			return nullptr;
-		}
-		else if (!ApplyOperator())
-			return nullptr;
-	}
+bool Parser::ParseBinaryExpr(uint8_t minPrecedence, uint32_t& result)
+{
+	if (!ParseUnaryExpr(result))
+		return false;
 
-	if (m_nodeStack.size() != 1)
+	// Loops over operators of the same or looser binding, only tighter ones recurse
+	while (true)
 	{
-		Logger::fmtLog(LogLevel::Error, "Mismatched operands and operators in expression!");
-		return nullptr;
-	}
+		TokenType op = peekType();
+		uint8_t precedence = g_binaryPrecedence[op];
+		if (precedence == 0 || precedence < minPrecedence)
+			return true;
+		consume();
 
-	mainExpr = std::move(m_nodeStack.top());
-	m_nodeStack.pop();
+		// All operators are left associative, the right operand may only hold tighter ones
+		uint32_t rhs;
+		if (!ParseBinaryExpr(precedence + 1, rhs))
+			return false;
 
-	return mainExpr;
+		ExprNode binOpNode{ ExprKind::Binary };
+		binOpNode.op = op;
+		binOpNode.lhs = result;
+		binOpNode.rhs = rhs;
+		result = PushNode(binOpNode);
+	}
 }
 
-std::unique_ptr<Expr> Parser::CreateVarExpr(const std::string& name)
+bool Parser::ParseUnaryExpr(uint32_t& result)
 {
-	auto IdentExpr = std::make_unique<Expr>();
+	if (m_exprDepth >= MAX_EXPR_DEPTH)
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expression nested too deeply on line: %lu", getLine()), false);
 
-	auto ident = std::make_unique<Ident>();
-	ident->name = name;
+	switch (peekType())
+	{
+	case TokenType::INT_LITERAL:
+		result = PushLiteralNode(m_tokens.getText(consume()), PrimitiveDataType::i32);
+		return true;
+	case TokenType::FLOAT_LITERAL:
+		result = PushLiteralNode(m_tokens.getText(consume()), PrimitiveDataType::f64);
+		return true;
+	case TokenType::STRING_LITERAL:
+		result = PushLiteralNode(m_tokens.getText(consume()), PrimitiveDataType::str);
+		return true;
+	case TokenType::IDENT:
+		if (PeekAndCheck(TokenType::LParan, 1))
+		{
+			if (!ParseFunctionCallExpr(result))
+				return false;
+		}
+		else if (PeekAndCheck(TokenType::LSQUARE, 1))
+		{
+			// Element of an array or slice, the index is parsed like a parenthesized expression
+			SymbolID name = consume().symbol;
+			consume(/* '[' */);
+			uint32_t index;
+			m_exprDepth++;
+			bool ok = ParseBinaryExpr(1, index);
+			m_exprDepth--;
+			if (!ok)
+				return false;
+			if (!match(TokenType::RSQUARE))
+				RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ']' on line: %lu", getLine(-1)), false);
 
-	IdentExpr->value = std::move(ident);
+			ExprNode indexNode{ ExprKind::Index };
+			indexNode.name = name;
+			indexNode.lhs = index;
+			result = PushNode(indexNode);
+		}
+		else
+		{
+			// This is a case where the ident is a variable
+			result = PushVarNode(consume().symbol);
+		}
+		return true;
+	case TokenType::LParan:
+	{
+		consume();
+		m_exprDepth++;
+		bool ok = ParseBinaryExpr(1, result);
+		m_exprDepth--;
+		if (!ok)
+			return false;
 
-	return IdentExpr;
+		if (!match(TokenType::RParan))
+			RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Expected a ')' on line: %lu", getLine(-1)), false);
+		return true;
+	}
+	case TokenType::MINUS:
+	{
+		consume();
+		// Binds tighter than any binary operator: -a * b is (-a) * b
+		uint32_t operand;
+		m_exprDepth++;
+		bool ok = ParseUnaryExpr(operand);
+		m_exprDepth--;
+		if (!ok)
+			return false;
+
+		ExprNode negNode{ ExprKind::Unary };
+		negNode.op = TokenType::MINUS;
+		negNode.lhs = operand;
+		result = PushNode(negNode);
+		return true;
+	}
+	default:
+		RUN_AND_RETURN(Logger::fmtLog(LogLevel::Error, "Unexpected token found on line: %lu", getLine()), false);
+	}
 }
 
-std::unique_ptr<Expr> Parser::CreateLiteralExpr(const std::string& value, PrimitiveDataType dataType)
+uint32_t Parser::PushNode(const ExprNode& node)
 {
-	auto LiteralExpr = std::make_unique<Expr>();
+	uint32_t index = static_cast<uint32_t>(m_exprNodes.size() - m_exprBase);
+	m_exprNodes.push_back(node);
+	m_exprNodeCount++;
+	return index;
+}
+
+uint32_t Parser::PushVarNode(SymbolID name)
+{
+	ExprNode node{ ExprKind::Ident };
+	node.name = name;
+	return PushNode(node);
+}
 
-	auto _Literal = std::make_unique<Literal>();
+uint32_t Parser::PushLiteralNode(std::string_view value, PrimitiveDataType dataType)
+{
+	Literal* _Literal = m_arena->New<Literal>();
 	_Literal->type = dataType;
-	_Literal->value = value;
+	// The token stream does not outlive the parser, the program keeps its own copy
+	_Literal->value = m_arena->CopyString(value);
 
-	LiteralExpr->value = std::move(_Literal);
-	
-	return LiteralExpr;
+	ExprNode node{ ExprKind::Literal };
+	node.literal = _Literal;
+	return PushNode(node);
+}
+
+uint32_t Parser::PushCallNode(FnCall* fnCall)
+{
+	ExprNode node{ ExprKind::Call };
+	node.call = fnCall;
+	return PushNode(node);
+}
+
+size_t Parser::getNodeCount() const
+{
+	// Expression nodes live in arrays, everything else is one arena object per node
+	return m_arena->getObjectCount() + m_exprNodeCount;
 }
 
 std::unique_ptr<Program> Parser::getProgram()
@@ -624,51 +826,54 @@ std::unique_ptr<Program> Parser::getProgram()
 	return std::move(m_programAST);
 }
 
-std::optional<Token> Parser::peek(int ahead)
+const Token* Parser::peek(int ahead) const
+{
+	size_t lookAt = m_index + ahead;
+	if (lookAt < m_tokens.size())
+		return &m_tokens[lookAt];
+	return nullptr;
+}
+
+TokenType Parser::peekType(int ahead) const
 {
 	size_t lookAt = m_index + ahead;
 	if (lookAt < m_tokens.size())
-		return m_tokens[lookAt];
-	return {};
+		return m_tokens[lookAt].type;
+	return TokenType::_EOF;
 }
 
-Token Parser::consume()
+const Token& Parser::consume()
 {
 	return m_tokens[m_index++];
 }
 
-std::optional<Token> Parser::PeekAndCheck(TokenType type, int ahead)
+const Token* Parser::PeekAndCheck(TokenType type, int ahead) const
 {
 	size_t lookAt = m_index + ahead;
 	if (lookAt < m_tokens.size() && m_tokens[lookAt].type == type)
-		return m_tokens[lookAt];
-	return {};
+		return &m_tokens[lookAt];
+	return nullptr;
 }
 
-bool Parser::ApplyOperator()
+bool Parser::match(TokenType type)
 {
-	if (m_nodeStack.size() < 2)
+	if (m_index < m_tokens.size() && m_tokens[m_index].type == type)
 	{
-		Logger::fmtLog(LogLevel::Error, "Insufficient operands for operator on line: %ld", m_operatorStack.top().lineNum);
-		return false;
+		m_index++;
+		return true;
 	}
+	return false;
+}
 
-	auto RHS = std::move(m_nodeStack.top());
-	m_nodeStack.pop();
-	auto LHS = std::move(m_nodeStack.top());
-	m_nodeStack.pop();
-
-	auto binOpNode = std::make_unique<BinaryOp>();
-	binOpNode->type = m_operatorStack.top().type;
-	binOpNode->LHS = std::move(LHS);
-	binOpNode->RHS = std::move(RHS);
-
-	auto expr = std::make_unique<Expr>();
-	expr->value = std::move(binOpNode);
-	m_nodeStack.push(std::move(expr));
-
-	m_operatorStack.pop();
-	return true;
+size_t Parser::getLine(int ahead) const
+{
+	// Clamp to the stream so diagnostics at either end still get a line
+	size_t lookAt = m_index + ahead;
+	if (ahead < 0 && m_index < (size_t)-ahead)
+		lookAt = 0;
+	if (lookAt >= m_tokens.size())
+		lookAt = m_tokens.size() - 1;
+	return m_tokens.getLine(m_tokens[lookAt]);
 }
 
 PrimitiveDataType Parser::ptrTypeof(PrimitiveDataType type)
@@ -0,0 +1,133 @@
+#include "headers/SSABuilder.h"
+
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/ValueHandle.h>
+
+void SSABuilder::Reset()
+{
+	m_variables.clear();
+	m_sealedBlocks.clear();
+	m_incompletePhis.clear();
+	m_phiVariables.clear();
+}
+
+SSABuilder::Variable SSABuilder::NewVariable(llvm::Type* type, llvm::StringRef name)
+{
+	// Built in place, DenseMap's default constructor is explicit and cannot come from a braced list
+	VariableInfo& info = m_variables.emplace_back();
+	info.type = type;
+	info.name = name;
+	return static_cast<Variable>(m_variables.size() - 1);
+}
+
+void SSABuilder::WriteVariable(Variable var, llvm::BasicBlock* block, llvm::Value* value)
+{
+	m_variables[var].currentDef[block] = value;
+}
+
+llvm::Value* SSABuilder::ReadVariable(Variable var, llvm::BasicBlock* block)
+{
+	auto& currentDef = m_variables[var].currentDef;
+	auto def = currentDef.find(block);
+	if (def != currentDef.end())
+		return def->second;
+	return ReadVariableRecursive(var, block);
+}
+
+void SSABuilder::SealBlock(llvm::BasicBlock* block)
+{
+	auto incomplete = m_incompletePhis.find(block);
+	if (incomplete != m_incompletePhis.end())
+	{
+		// Completing a phi may read through other blocks and add to the map, so the list is moved out first
+		auto phis = std::move(incomplete->second);
+		m_incompletePhis.erase(incomplete);
+		for (auto& [var, phi] : phis)
+			AddPhiOperands(var, phi);
+	}
+	m_sealedBlocks.insert(block);
+}
+
+llvm::Value* SSABuilder::ReadVariableRecursive(Variable var, llvm::BasicBlock* block)
+{
+	llvm::Value* value = nullptr;
+	if (!m_sealedBlocks.count(block))
+	{
+		// More predecessors may still come, the operands are added by SealBlock
+		llvm::PHINode* phi = CreatePhi(var, block);
+		m_incompletePhis[block].push_back({ var, phi });
+		value = phi;
+	}
+	else if (llvm::BasicBlock* predecessor = block->getUniquePredecessor())
+		value = ReadVariable(var, predecessor);
+	else if (llvm::pred_empty(block))
+	{
+		// Read on a path that never assigned the variable
+		value = llvm::UndefValue::get(m_variables[var].type);
+	}
+	else
+	{
+		// The phi is written first, a loop leading back here then finds it instead of recursing forever
+		llvm::PHINode* phi = CreatePhi(var, block);
+		WriteVariable(var, block, phi);
+		value = AddPhiOperands(var, phi);
+	}
+	WriteVariable(var, block, value);
+	return value;
+}
+
+llvm::Value* SSABuilder::AddPhiOperands(Variable var, llvm::PHINode* phi)
+{
+	for (llvm::BasicBlock* predecessor : llvm::predecessors(phi->getParent()))
+		phi->addIncoming(ReadVariable(var, predecessor), predecessor);
+	return TryRemoveTrivialPhi(phi);
+}
+
+llvm::Value* SSABuilder::TryRemoveTrivialPhi(llvm::PHINode* phi)
+{
+	llvm::Value* same = nullptr;
+	for (llvm::Value* operand : phi->incoming_values())
+	{
+		if (operand == same || operand == phi)
+			continue;
+		// Merges at least two values
+		if (same != nullptr)
+			return phi;
+		same = operand;
+	}
+	// Only reachable through itself, or from the entry without a definition
+	if (same == nullptr)
+		same = llvm::UndefValue::get(phi->getType());
+
+	llvm::SmallVector<llvm::PHINode*, 8> phiUsers;
+	for (llvm::User* user : phi->users())
+		if (auto* userPhi = llvm::dyn_cast<llvm::PHINode>(user); userPhi != nullptr && userPhi != phi)
+			phiUsers.push_back(userPhi);
+
+	phi->replaceAllUsesWith(same);
+	auto phiVariable = m_phiVariables.find(phi);
+	for (auto& def : m_variables[phiVariable->second].currentDef)
+		if (def.second == phi)
+			def.second = same;
+	m_phiVariables.erase(phiVariable);
+	phi->eraseFromParent();
+
+	// Removing this phi may have made its users trivial. same can be one of them,
+	// the handle follows it to whatever replaces it
+	llvm::WeakTrackingVH result(same);
+	for (llvm::PHINode* user : phiUsers)
+		if (m_phiVariables.count(user))
+			TryRemoveTrivialPhi(user);
+	return result;
+}
+
+llvm::PHINode* SSABuilder::CreatePhi(Variable var, llvm::BasicBlock* block)
+{
+	const VariableInfo& info = m_variables[var];
+	llvm::PHINode* phi = block->empty()
+		? llvm::PHINode::Create(info.type, 0, info.name, block)
+		: llvm::PHINode::Create(info.type, 0, info.name, &block->front());
+	m_phiVariables[phi] = var;
+	return phi;
+}
@@ -0,0 +1,440 @@
+#include "headers/Scan.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define VERITAS_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 code lives in this same file, gcc/clang need the target attribute to accept it
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+static inline unsigned countTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static inline unsigned popCount(uint32_t x)
+{
+	x = x - ((x >> 1) & 0x55555555u);
+	x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+	return (((x + (x >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+// Bits below `idx`
+static inline uint32_t lowBits(unsigned idx)
+{
+	return idx >= 32 ? 0xFFFFFFFFu : (1u << idx) - 1;
+}
+
+/* ---------------------------------- Scalar ---------------------------------- */
+
+static const char* skipWhitespaceScalar(const char* p, const char* end, size_t& newlines)
+{
+	while (p < end && isSpaceChar(*p))
+	{
+		if (*p == '\n')
+			newlines++;
+		p++;
+	}
+	return p;
+}
+
+static const char* skipAlnumScalar(const char* p, const char* end)
+{
+	while (p < end && isAlnumChar(*p))
+		p++;
+	return p;
+}
+
+static const char* skipDigitsScalar(const char* p, const char* end)
+{
+	while (p < end && isDigitChar(*p))
+		p++;
+	return p;
+}
+
+static const char* findLineEndScalar(const char* p, const char* end)
+{
+	const void* nl = std::memchr(p, '\n', end - p);
+	return nl != nullptr ? static_cast<const char*>(nl) : end;
+}
+
+static const char* findBlockCommentEndScalar(const char* p, const char* end, size_t& newlines)
+{
+	for (; p < end; p++)
+	{
+		if (*p == '*' && p + 1 < end && p[1] == '/')
+			return p;
+		if (*p == '\n')
+			newlines++;
+	}
+	return end;
+}
+
+static const char* findStringSpecialScalar(const char* p, const char* end, size_t& newlines)
+{
+	for (; p < end; p++)
+	{
+		if (*p == '"' || *p == '\\')
+			return p;
+		if (*p == '\n')
+			newlines++;
+	}
+	return end;
+}
+
+static const ScanFunctions s_scalarScan = {
+	skipWhitespaceScalar,
+	skipAlnumScalar,
+	skipDigitsScalar,
+	findLineEndScalar,
+	findBlockCommentEndScalar,
+	findStringSpecialScalar,
+	"scalar"
+};
+
+#ifdef VERITAS_SCAN_X86
+/* ----------------------------------- SSE2 ----------------------------------- */
+
+static inline uint32_t eqMaskSSE2(__m128i v, char c)
+{
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+// Bytes in [lo, hi], unsigned compare done through min
+static inline __m128i inRangeSSE2(__m128i v, char lo, char hi)
+{
+	__m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8((char)(hi - lo))), shifted);
+}
+
+static inline uint32_t spaceMaskSSE2(__m128i v)
+{
+	// '\t' '\n' '\v' '\f' '\r' are contiguous
+	__m128i ws = _mm_or_si128(inRangeSSE2(v, '\t', '\r'), _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+	return (uint32_t)_mm_movemask_epi8(ws);
+}
+
+static inline uint32_t digitMaskSSE2(__m128i v)
+{
+	return (uint32_t)_mm_movemask_epi8(inRangeSSE2(v, '0', '9'));
+}
+
+static inline uint32_t alnumMaskSSE2(__m128i v)
+{
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i alnum = _mm_or_si128(inRangeSSE2(lower, 'a', 'z'), inRangeSSE2(v, '0', '9'));
+	return (uint32_t)_mm_movemask_epi8(alnum);
+}
+
+static inline __m128i loadSSE2(const char* p)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static const char* skipWhitespaceSSE2(const char* p, const char* end, size_t& newlines)
+{
+	while (end - p >= 16)
+	{
+		__m128i v = loadSSE2(p);
+		uint32_t stop = ~spaceMaskSSE2(v) & 0xFFFFu;
+		uint32_t nl = eqMaskSSE2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 16;
+	}
+	return skipWhitespaceScalar(p, end, newlines);
+}
+
+static const char* skipAlnumSSE2(const char* p, const char* end)
+{
+	while (end - p >= 16)
+	{
+		uint32_t stop = ~alnumMaskSSE2(loadSSE2(p)) & 0xFFFFu;
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 16;
+	}
+	return skipAlnumScalar(p, end);
+}
+
+static const char* skipDigitsSSE2(const char* p, const char* end)
+{
+	while (end - p >= 16)
+	{
+		uint32_t stop = ~digitMaskSSE2(loadSSE2(p)) & 0xFFFFu;
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 16;
+	}
+	return skipDigitsScalar(p, end);
+}
+
+static const char* findLineEndSSE2(const char* p, const char* end)
+{
+	while (end - p >= 16)
+	{
+		uint32_t stop = eqMaskSSE2(loadSSE2(p), '\n');
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 16;
+	}
+	return findLineEndScalar(p, end);
+}
+
+static const char* findBlockCommentEndSSE2(const char* p, const char* end, size_t& newlines)
+{
+	// One extra byte is needed to look at the char following each '*'
+	while (end - p >= 17)
+	{
+		__m128i v = loadSSE2(p);
+		uint32_t stop = eqMaskSSE2(v, '*') & eqMaskSSE2(loadSSE2(p + 1), '/');
+		uint32_t nl = eqMaskSSE2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 16;
+	}
+	return findBlockCommentEndScalar(p, end, newlines);
+}
+
+static const char* findStringSpecialSSE2(const char* p, const char* end, size_t& newlines)
+{
+	while (end - p >= 16)
+	{
+		__m128i v = loadSSE2(p);
+		uint32_t stop = eqMaskSSE2(v, '"') | eqMaskSSE2(v, '\\');
+		uint32_t nl = eqMaskSSE2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 16;
+	}
+	return findStringSpecialScalar(p, end, newlines);
+}
+
+static const ScanFunctions s_sse2Scan = {
+	skipWhitespaceSSE2,
+	skipAlnumSSE2,
+	skipDigitsSSE2,
+	findLineEndSSE2,
+	findBlockCommentEndSSE2,
+	findStringSpecialSSE2,
+	"sse2"
+};
+
+/* ----------------------------------- AVX2 ----------------------------------- */
+
+TARGET_AVX2 static inline uint32_t eqMaskAVX2(__m256i v, char c)
+{
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+
+TARGET_AVX2 static inline __m256i inRangeAVX2(__m256i v, char lo, char hi)
+{
+	__m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8((char)(hi - lo))), shifted);
+}
+
+TARGET_AVX2 static inline uint32_t spaceMaskAVX2(__m256i v)
+{
+	__m256i ws = _mm256_or_si256(inRangeAVX2(v, '\t', '\r'), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+	return (uint32_t)_mm256_movemask_epi8(ws);
+}
+
+TARGET_AVX2 static inline uint32_t digitMaskAVX2(__m256i v)
+{
+	return (uint32_t)_mm256_movemask_epi8(inRangeAVX2(v, '0', '9'));
+}
+
+TARGET_AVX2 static inline uint32_t alnumMaskAVX2(__m256i v)
+{
+	__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	__m256i alnum = _mm256_or_si256(inRangeAVX2(lower, 'a', 'z'), inRangeAVX2(v, '0', '9'));
+	return (uint32_t)_mm256_movemask_epi8(alnum);
+}
+
+TARGET_AVX2 static inline __m256i loadAVX2(const char* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+TARGET_AVX2 static const char* skipWhitespaceAVX2(const char* p, const char* end, size_t& newlines)
+{
+	while (end - p >= 32)
+	{
+		__m256i v = loadAVX2(p);
+		uint32_t stop = ~spaceMaskAVX2(v);
+		uint32_t nl = eqMaskAVX2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 32;
+	}
+	return skipWhitespaceSSE2(p, end, newlines);
+}
+
+TARGET_AVX2 static const char* skipAlnumAVX2(const char* p, const char* end)
+{
+	while (end - p >= 32)
+	{
+		uint32_t stop = ~alnumMaskAVX2(loadAVX2(p));
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 32;
+	}
+	return skipAlnumSSE2(p, end);
+}
+
+TARGET_AVX2 static const char* skipDigitsAVX2(const char* p, const char* end)
+{
+	while (end - p >= 32)
+	{
+		uint32_t stop = ~digitMaskAVX2(loadAVX2(p));
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 32;
+	}
+	return skipDigitsSSE2(p, end);
+}
+
+TARGET_AVX2 static const char* findLineEndAVX2(const char* p, const char* end)
+{
+	while (end - p >= 32)
+	{
+		uint32_t stop = eqMaskAVX2(loadAVX2(p), '\n');
+		if (stop != 0)
+			return p + countTrailingZeros(stop);
+		p += 32;
+	}
+	return findLineEndSSE2(p, end);
+}
+
+TARGET_AVX2 static const char* findBlockCommentEndAVX2(const char* p, const char* end, size_t& newlines)
+{
+	while (end - p >= 33)
+	{
+		__m256i v = loadAVX2(p);
+		uint32_t stop = eqMaskAVX2(v, '*') & eqMaskAVX2(loadAVX2(p + 1), '/');
+		uint32_t nl = eqMaskAVX2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 32;
+	}
+	return findBlockCommentEndSSE2(p, end, newlines);
+}
+
+TARGET_AVX2 static const char* findStringSpecialAVX2(const char* p, const char* end, size_t& newlines)
+{
+	while (end - p >= 32)
+	{
+		__m256i v = loadAVX2(p);
+		uint32_t stop = eqMaskAVX2(v, '"') | eqMaskAVX2(v, '\\');
+		uint32_t nl = eqMaskAVX2(v, '\n');
+		if (stop != 0)
+		{
+			unsigned idx = countTrailingZeros(stop);
+			newlines += popCount(nl & lowBits(idx));
+			return p + idx;
+		}
+		newlines += popCount(nl);
+		p += 32;
+	}
+	return findStringSpecialSSE2(p, end, newlines);
+}
+
+static const ScanFunctions s_avx2Scan = {
+	skipWhitespaceAVX2,
+	skipAlnumAVX2,
+	skipDigitsAVX2,
+	findLineEndAVX2,
+	findBlockCommentEndAVX2,
+	findStringSpecialAVX2,
+	"avx2"
+};
+
+static bool cpuHasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// OSXSAVE + AVX, and the OS must save the ymm registers
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // VERITAS_SCAN_X86
+
+static const ScanFunctions& selectScanFunctions()
+{
+	// VERITAS_SCAN=scalar|sse2|avx2 forces an implementation (only downgrades are honoured)
+	const char* forced = std::getenv("VERITAS_SCAN");
+	if (forced != nullptr && std::strcmp(forced, "scalar") == 0)
+		return s_scalarScan;
+
+#ifdef VERITAS_SCAN_X86
+	if (forced != nullptr && std::strcmp(forced, "sse2") == 0)
+		return s_sse2Scan;
+	if (cpuHasAVX2())
+		return s_avx2Scan;
+	return s_sse2Scan;
+#else
+	return s_scalarScan;
+#endif
+}
+
+const ScanFunctions& getScanFunctions()
+{
+	static const ScanFunctions& selected = selectScanFunctions();
+	return selected;
+}
@@ -0,0 +1,283 @@
+#include "headers/ShardedGenerator.h"
+#include "headers/Logger.h"
+
+#include <algorithm>
+#include <numeric>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Linker/Linker.h>
+
+// Rough size of the code a statement generates, only used to balance the shards
+static size_t estimateCost(const Expr* expr);
+
+static size_t estimateCost(const CompoundStmt* compoundStmt)
+{
+	size_t cost = 0;
+	for (const Stmt* stmt : compoundStmt->statementList)
+	{
+		if (auto declStmt = std::get_if<DeclStmt*>(&stmt->stmt))
+			cost += 1 + ((*declStmt)->expr != nullptr ? estimateCost((*declStmt)->expr) : 0);
+		else if (auto assignStmt = std::get_if<AssignStmt*>(&stmt->stmt))
+			cost += 1 + estimateCost((*assignStmt)->value) + ((*assignStmt)->index != nullptr ? estimateCost((*assignStmt)->index) : 0);
+		else if (auto retStmt = std::get_if<ReturnStmt*>(&stmt->stmt))
+			cost += 1 + ((*retStmt)->value != nullptr ? estimateCost((*retStmt)->value) : 0);
+		else if (auto fnCall = std::get_if<FnCall*>(&stmt->stmt))
+		{
+			cost += 1;
+			if ((*fnCall)->args != nullptr)
+				for (const Expr* arg : (*fnCall)->args->list)
+					cost += estimateCost(arg);
+		}
+		else if (auto nested = std::get_if<CompoundStmt*>(&stmt->stmt))
+			cost += estimateCost(*nested);
+		else if (auto forStmt = std::get_if<ForStmt*>(&stmt->stmt))
+			cost += 4 + estimateCost((*forStmt)->start) + estimateCost((*forStmt)->end) + estimateCost((*forStmt)->body);
+	}
+	return cost;
+}
+
+static size_t estimateCost(const Expr* expr)
+{
+	size_t cost = expr->nodes.size();
+	for (const ExprNode& node : expr->nodes)
+		if (node.kind == ExprKind::Call && node.call->args != nullptr)
+			for (const Expr* arg : node.call->args->list)
+				cost += estimateCost(arg);
+	return cost;
+}
+
+ShardedGenerator::ShardedGenerator(const Program& program, StringInterner& interner, const std::string& moduleName, const std::string& outPath, unsigned shardCount)
+	: m_program(program)
+{
+	// More shards than functions would only produce empty modules
+	size_t count = std::max<size_t>(1, std::min<size_t>(shardCount, program.FnStmts.size()));
+
+	// Constructed here, on one thread, because a Generator interns the names it needs
+	for (size_t i = 0; i < count; i++)
+		m_shards.push_back(std::make_unique<Generator>(program, interner, moduleName, outPath));
+
+	if (count > 1)
+	{
+		llvm::ThreadPoolStrategy strategy = llvm::hardware_concurrency(static_cast<unsigned>(count));
+		strategy.Limit = true;
+		m_pool = std::make_unique<llvm::ThreadPool>(strategy);
+		Partition();
+	}
+}
+
+void ShardedGenerator::Partition()
+{
+	const std::vector<FnStmt*>& functions = m_program.FnStmts;
+
+	std::vector<size_t> costs(functions.size(), 0);
+	for (size_t i = 0; i < functions.size(); i++)
+		if (functions[i]->compoundStmt != nullptr)
+			costs[i] = estimateCost(functions[i]->compoundStmt);
+
+	// Largest function first, each to the shard with the least work so far
+	std::vector<size_t> order(functions.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+	std::vector<std::vector<bool>> defined(m_shards.size(), std::vector<bool>(functions.size(), false));
+	std::vector<size_t> load(m_shards.size(), 0);
+	for (size_t fn : order)
+	{
+		size_t shard = std::min_element(load.begin(), load.end()) - load.begin();
+		defined[shard][fn] = true;
+		load[shard] += costs[fn] + 1;
+	}
+
+	// Globals live in the first shard only
+	for (size_t i = 0; i < m_shards.size(); i++)
+		m_shards[i]->SetShard(std::move(defined[i]), i == 0);
+}
+
+template <typename Work>
+bool ShardedGenerator::RunOnShards(Work work)
+{
+	if (m_pool == nullptr)
+	{
+		bool result = true;
+		for (size_t i = 0; i < m_shards.size(); i++)
+			result &= work(i);
+		return result;
+	}
+
+	// Diagnostics of the shards go where those of the calling thread do
+	LogSink* sink = Logger::GetThreadSink();
+	std::vector<std::shared_future<bool>> results;
+	results.reserve(m_shards.size());
+	for (size_t i = 0; i < m_shards.size(); i++)
+	{
+		results.push_back(m_pool->async([&work, sink, i]
+		{
+			LogSink* previousSink = Logger::GetThreadSink();
+			Logger::SetThreadSink(sink);
+			bool result = work(i);
+			Logger::SetThreadSink(previousSink);
+			return result;
+		}));
+	}
+
+	bool result = true;
+	for (auto& shardResult : results)
+		result &= shardResult.get();
+	return result;
+}
+
+bool ShardedGenerator::InitTarget(const CompileOptions& options)
+{
+	// Cheap, and every shard needs its own target machine to run on its own thread
+	for (auto& shard : m_shards)
+		if (!shard->InitTarget(options))
+			return false;
+	return true;
+}
+
+void ShardedGenerator::SetConstEvalLimits(const ConstEvalLimits& limits)
+{
+	for (auto& shard : m_shards)
+		shard->SetConstEvalLimits(limits);
+}
+
+bool ShardedGenerator::Generate()
+{
+	return RunOnShards([this](size_t i) { return m_shards[i]->Generate(); });
+}
+
+bool ShardedGenerator::VerifyModules()
+{
+	return RunOnShards([this](size_t i) { return m_shards[i]->VerifyModule(); });
+}
+
+void ShardedGenerator::OptimizeModules(OptLevel level, bool verifyEach)
+{
+	RunOnShards([this, level, verifyEach](size_t i)
+	{
+		m_shards[i]->OptimizeModule(level, verifyEach);
+		return true;
+	});
+}
+
+bool ShardedGenerator::EmitObjects(const std::string& basePath, std::vector<std::string>& objects)
+{
+	size_t first = objects.size();
+	for (size_t i = 0; i < m_shards.size(); i++)
+		objects.push_back(m_shards.size() == 1 ? basePath + ".o" : basePath + "." + std::to_string(i) + ".o");
+
+	return RunOnShards([this, &objects, first](size_t i)
+	{
+		return m_shards[i]->EmitMachineCode(objects[first + i], llvm::CGFT_ObjectFile);
+	});
+}
+
+bool ShardedGenerator::MergeShards()
+{
+	if (m_shards.size() == 1)
+		return true;
+
+	// Modules of different contexts only link after a trip through bitcode, the writing runs in parallel
+	std::vector<llvm::SmallVector<char, 0>> buffers(m_shards.size());
+	RunOnShards([this, &buffers](size_t i)
+	{
+		if (i == 0)
+			return true;
+		llvm::raw_svector_ostream out(buffers[i]);
+		llvm::WriteBitcodeToFile(*m_shards[i]->cModule, out);
+		m_shards[i].reset();
+		return true;
+	});
+
+	Generator& merged = *m_shards[0];
+	llvm::Linker linker(*merged.cModule);
+	for (size_t i = 1; i < buffers.size(); i++)
+	{
+		llvm::MemoryBufferRef buffer(llvm::StringRef(buffers[i].data(), buffers[i].size()), merged.m_moduleName);
+		auto shardModule = llvm::parseBitcodeFile(buffer, *merged.ctx);
+		if (!shardModule)
+		{
+			Logger::fmtLog(LogLevel::Error, "Failed to read back shard %zu: %s", i, llvm::toString(shardModule.takeError()).c_str());
+			return false;
+		}
+		// linkInModule returns true on error
+		if (linker.linkInModule(std::move(*shardModule)))
+		{
+			Logger::fmtLog(LogLevel::Error, "Failed to link shard %zu into '%s'", i, merged.m_moduleName.c_str());
+			return false;
+		}
+		buffers[i].clear();
+	}
+	m_shards.resize(1);
+
+	// Functions only had to be visible to the other shards, and are put back in source order
+	auto& functionList = merged.cModule->getFunctionList();
+	llvm::SmallPtrSet<llvm::Function*, 32> placed;
+	for (const FnStmt* fnStmt : m_program.FnStmts)
+	{
+		llvm::Function* fn = merged.cModule->getFunction(merged.getName(fnStmt->name));
+		if (fn == nullptr || !placed.insert(fn).second)
+			continue;
+		if (!fnStmt->isExtern && fnStmt->name != merged.m_mainSymbol)
+		{
+			fn->setLinkage(llvm::GlobalValue::InternalLinkage);
+			fn->setVisibility(llvm::GlobalValue::DefaultVisibility);
+		}
+		functionList.splice(functionList.end(), functionList, fn->getIterator());
+	}
+
+	// String literals are unnamed, ordering them by first use numbers them as without shards
+	auto& globalList = merged.cModule->getGlobalList();
+	llvm::SmallPtrSet<llvm::GlobalVariable*, 32> ordered;
+	auto placeLiteral = [&](llvm::Value* value)
+	{
+		if (auto constExpr = llvm::dyn_cast<llvm::ConstantExpr>(value))
+			value = constExpr->getOperand(0);
+		auto global = llvm::dyn_cast<llvm::GlobalVariable>(value);
+		if (global != nullptr && !global->hasName() && ordered.insert(global).second)
+			globalList.splice(globalList.end(), globalList, global->getIterator());
+	};
+	for (llvm::Function& fn : *merged.cModule)
+		for (llvm::BasicBlock& block : fn)
+			for (llvm::Instruction& inst : block)
+				for (llvm::Value* operand : inst.operands())
+					placeLiteral(operand);
+	return true;
+}
+
+Generator& ShardedGenerator::getMerged()
+{
+	return *m_shards[0];
+}
+
+std::vector<llvm::orc::ThreadSafeModule> ShardedGenerator::takeModules()
+{
+	std::vector<llvm::orc::ThreadSafeModule> modules;
+	for (auto& shard : m_shards)
+		modules.push_back(shard->takeModule());
+	return modules;
+}
+
+void ShardedGenerator::PrintModules(llvm::raw_ostream& out) const
+{
+	for (auto& shard : m_shards)
+		shard->PrintModule(out);
+}
+
+const llvm::TargetMachine* ShardedGenerator::getTargetMachine() const
+{
+	return m_shards[0]->m_targetMachine.get();
+}
+
+size_t ShardedGenerator::getInstructionCount() const
+{
+	size_t count = 0;
+	for (auto& shard : m_shards)
+		count += shard->getInstructionCount();
+	return count;
+}
+
+size_t ShardedGenerator::getShardCount() const
+{
+	return m_shards.size();
+}
@@ -0,0 +1,137 @@
+#include "headers/SourceFile.h"
+
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile()
+{
+	Close();
+}
+
+bool SourceFile::Open(const std::string& path)
+{
+	Close();
+	m_path = path;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return ReadFallback();
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return ReadFallback();
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return ReadFallback();
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_mapped = true;
+	return true;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+	{
+		close(fd);
+		return ReadFallback();
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return ReadFallback();
+
+	madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<size_t>(st.st_size);
+	m_mapped = true;
+	return true;
+#endif
+}
+
+void SourceFile::Close()
+{
+	if (m_mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+		CloseHandle(static_cast<HANDLE>(m_fileHandle));
+		m_mappingHandle = nullptr;
+		m_fileHandle = nullptr;
+#else
+		munmap(const_cast<char*>(m_data), m_size);
+#endif
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;
+	m_fallbackBuffer.clear();
+}
+
+std::string_view SourceFile::getBuffer() const
+{
+	return std::string_view(m_data, m_size);
+}
+
+const std::string& SourceFile::getPath() const
+{
+	return m_path;
+}
+
+bool SourceFile::isMapped() const
+{
+	return m_mapped;
+}
+
+bool SourceFile::ReadFallback()
+{
+	std::ifstream in(m_path, std::ios::binary);
+	if (!in.is_open())
+		return false;
+
+	std::ostringstream sstr;
+	sstr << in.rdbuf();
+	m_fallbackBuffer = sstr.str();
+
+	m_data = m_fallbackBuffer.data();
+	m_size = m_fallbackBuffer.size();
+	return true;
+}
@@ -0,0 +1,61 @@
+#include "headers/SymbolTable.h"
+
+bool SymbolTable::Declare(SymbolID id, const varInfo& info)
+{
+	if (id >= m_slots.size())
+		m_slots.resize(id + 1);
+
+	Slot& slot = m_slots[id];
+	uint32_t depth = getDepth();
+	if (slot.depth == depth)
+		return false;
+
+	// Globals are never popped, nothing to restore them to
+	if (!m_scopeStarts.empty())
+		m_undoLog.push_back({ id, slot });
+	slot.info = info;
+	slot.depth = depth;
+	return true;
+}
+
+const varInfo* SymbolTable::Lookup(SymbolID id) const
+{
+	if (id >= m_slots.size() || m_slots[id].depth == 0)
+		return nullptr;
+	return &m_slots[id].info;
+}
+
+bool SymbolTable::isDeclaredInScope(SymbolID id) const
+{
+	return id < m_slots.size() && m_slots[id].depth == getDepth();
+}
+
+void SymbolTable::PushScope()
+{
+	m_scopeStarts.push_back(m_undoLog.size());
+}
+
+void SymbolTable::PopScope()
+{
+	size_t start = m_scopeStarts.back();
+	m_scopeStarts.pop_back();
+
+	// Latest first, a symbol declared twice in nested scopes ends up with its oldest slot
+	while (m_undoLog.size() > start)
+	{
+		const UndoEntry& entry = m_undoLog.back();
+		m_slots[entry.id] = entry.previous;
+		m_undoLog.pop_back();
+	}
+}
+
+void SymbolTable::Reserve(size_t symbolCount)
+{
+	if (symbolCount > m_slots.size())
+		m_slots.resize(symbolCount);
+}
+
+uint32_t SymbolTable::getDepth() const
+{
+	return static_cast<uint32_t>(m_scopeStarts.size()) + 1;
+}
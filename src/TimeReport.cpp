@@ -0,0 +1,403 @@
+#include "headers/TimeReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <new>
+
+#include <llvm/Support/ErrorHandling.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	// Allocations made by one thread. Only that thread writes the count, so counting shares no cache line
+	// between threads. The process wide count sums the threads, which are linked in on their first count
+	struct ThreadAllocations
+	{
+		std::atomic<uint64_t> count{ 0 };
+		ThreadAllocations* next = nullptr;
+		bool isLinked = false;
+
+		~ThreadAllocations();
+	};
+}
+
+// Every allocation of the process goes through operator new, which is how phases get their allocation count.
+// Nothing is counted unless an AllocationCounting scope is open, i.e. a report was asked for
+static std::atomic<uint32_t> g_countingScopes{ 0 };
+static std::mutex g_threadsMutex;
+static ThreadAllocations* g_threads = nullptr;
+// Counts of the threads that have exited
+static uint64_t g_exitedAllocations = 0;
+static thread_local ThreadAllocations t_allocations;
+
+ThreadAllocations::~ThreadAllocations()
+{
+	if (!isLinked)
+		return;
+	std::lock_guard<std::mutex> lock(g_threadsMutex);
+	ThreadAllocations** link = &g_threads;
+	while (*link != this)
+		link = &(*link)->next;
+	*link = next;
+	g_exitedAllocations += count.load(std::memory_order_relaxed);
+}
+
+static void countAllocation()
+{
+	ThreadAllocations& allocations = t_allocations;
+	if (!allocations.isLinked)
+	{
+		std::lock_guard<std::mutex> lock(g_threadsMutex);
+		allocations.next = g_threads;
+		g_threads = &allocations;
+		allocations.isLinked = true;
+	}
+	allocations.count.store(allocations.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	if (g_countingScopes.load(std::memory_order_relaxed) != 0)
+		countAllocation();
+	// LLVM is built without exceptions, a failed allocation ends the process the way LLVM's own do
+	void* ptr = std::malloc(size ? size : 1);
+	if (ptr == nullptr)
+		llvm::report_bad_alloc_error("Allocation failed");
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+TimeReport::TimeReport(bool perThread)
+	: m_perThread(perThread)
+{
+}
+
+TimeReport::AllocationCounting::AllocationCounting(bool enabled)
+	: m_enabled(enabled)
+{
+	if (m_enabled)
+		g_countingScopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+TimeReport::AllocationCounting::~AllocationCounting()
+{
+	if (m_enabled)
+		g_countingScopes.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void TimeReport::BeginPhase(const char* name)
+{
+	PhaseStats phase;
+	phase.name = name;
+	m_phases.push_back(std::move(phase));
+
+	m_phaseAllocStart = readAllocationCount();
+	m_phaseCPUStart = readCPUTimeMs();
+	m_phaseWallStart = getWallTimeMs();
+}
+
+void TimeReport::EndPhase()
+{
+	double wallEnd = getWallTimeMs();
+	double cpuEnd = readCPUTimeMs();
+
+	PhaseStats& phase = m_phases.back();
+	phase.wallMs = wallEnd - m_phaseWallStart;
+	phase.cpuMs = cpuEnd - m_phaseCPUStart;
+	phase.allocations = readAllocationCount() - m_phaseAllocStart;
+	phase.peakRssKB = getPeakRssKB();
+}
+
+void TimeReport::SetCount(const char* name, uint64_t value)
+{
+	for (auto& count : m_counts)
+	{
+		if (count.first == name)
+		{
+			count.second = value;
+			return;
+		}
+	}
+	m_counts.emplace_back(name, value);
+}
+
+const std::vector<PhaseStats>& TimeReport::getPhases() const
+{
+	return m_phases;
+}
+
+void TimeReport::Merge(const TimeReport& other)
+{
+	for (const PhaseStats& otherPhase : other.m_phases)
+	{
+		auto phase = std::find_if(m_phases.begin(), m_phases.end(), [&otherPhase](const PhaseStats& p) { return p.name == otherPhase.name; });
+		if (phase == m_phases.end())
+		{
+			m_phases.push_back(otherPhase);
+			continue;
+		}
+		phase->wallMs += otherPhase.wallMs;
+		phase->cpuMs += otherPhase.cpuMs;
+		phase->allocations += otherPhase.allocations;
+		phase->peakRssKB = std::max(phase->peakRssKB, otherPhase.peakRssKB);
+	}
+
+	for (const auto& otherCount : other.m_counts)
+	{
+		auto count = std::find_if(m_counts.begin(), m_counts.end(), [&otherCount](const auto& c) { return c.first == otherCount.first; });
+		if (count == m_counts.end())
+			m_counts.push_back(otherCount);
+		else
+			count->second += otherCount.second;
+	}
+}
+
+void TimeReport::PrintText(std::ostream& out, const char* title) const
+{
+	char line[128];
+	double totalWall = 0.0, totalCPU = 0.0;
+	uint64_t totalAllocs = 0, peakRss = 0;
+
+	// Title centered in a 63 column rule
+	std::string rule = std::string(" ") + title + " ";
+	size_t dashes = rule.size() < 57 ? 57 - rule.size() : 0;
+	out << "===" << std::string(dashes / 2, '-') << rule << std::string(dashes - dashes / 2, '-') << "===\n";
+	std::snprintf(line, sizeof(line), "%-12s %12s %12s %14s %12s\n", "phase", "wall (ms)", "cpu (ms)", "peak RSS (MB)", "allocs");
+	out << line;
+
+	for (const PhaseStats& phase : m_phases)
+	{
+		std::snprintf(line, sizeof(line), "%-12s %12.3f %12.3f %14.1f %12llu\n", phase.name.c_str(), phase.wallMs, phase.cpuMs,
+			phase.peakRssKB / 1024.0, (unsigned long long)phase.allocations);
+		out << line;
+
+		totalWall += phase.wallMs;
+		totalCPU += phase.cpuMs;
+		totalAllocs += phase.allocations;
+		if (phase.peakRssKB > peakRss)
+			peakRss = phase.peakRssKB;
+	}
+
+	std::snprintf(line, sizeof(line), "%-12s %12.3f %12.3f %14.1f %12llu\n", "total", totalWall, totalCPU, peakRss / 1024.0, (unsigned long long)totalAllocs);
+	out << line;
+
+	for (const auto& count : m_counts)
+	{
+		std::snprintf(line, sizeof(line), "%-16s %llu\n", count.first.c_str(), (unsigned long long)count.second);
+		out << line;
+	}
+}
+
+void TimeReport::PrintJSON(std::ostream& out) const
+{
+	WriteJSON(out);
+	out << '\n';
+}
+
+void TimeReport::WriteJSON(std::ostream& out) const
+{
+	char number[64];
+	out << "{\"phases\":[";
+	for (size_t i = 0; i < m_phases.size(); i++)
+	{
+		const PhaseStats& phase = m_phases[i];
+		if (i != 0)
+			out << ',';
+		// Phase names are fixed identifiers, nothing needs escaping
+		out << "{\"name\":\"" << phase.name << "\"";
+		std::snprintf(number, sizeof(number), "%.3f", phase.wallMs);
+		out << ",\"wall_ms\":" << number;
+		std::snprintf(number, sizeof(number), "%.3f", phase.cpuMs);
+		out << ",\"cpu_ms\":" << number;
+		out << ",\"peak_rss_kb\":" << phase.peakRssKB;
+		out << ",\"allocations\":" << phase.allocations << '}';
+	}
+	out << "],\"counts\":{";
+	for (size_t i = 0; i < m_counts.size(); i++)
+	{
+		if (i != 0)
+			out << ',';
+		out << '"' << m_counts[i].first << "\":" << m_counts[i].second;
+	}
+	out << "}}";
+}
+
+// File names are the only free text in a report
+static void writeJSONString(std::ostream& out, const std::string& str)
+{
+	out << '"';
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out << escaped;
+		}
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+void TimeReport::PrintBuildText(std::ostream& out, const std::vector<std::string>& files, const std::vector<TimeReport>& reports, const TimeReport& build)
+{
+	char line[256];
+	TimeReport total;
+
+	out << "===------------------ Veritas build report -----------------===\n";
+	std::snprintf(line, sizeof(line), "%-32s %12s %12s %12s %10s\n", "file", "wall (ms)", "cpu (ms)", "allocs", "tokens");
+	out << line;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		const TimeReport& report = reports[i];
+		double wall = 0.0, cpu = 0.0;
+		uint64_t allocs = 0, tokens = 0;
+		for (const PhaseStats& phase : report.m_phases)
+		{
+			wall += phase.wallMs;
+			cpu += phase.cpuMs;
+			allocs += phase.allocations;
+		}
+		for (const auto& count : report.m_counts)
+			if (count.first == "tokens")
+				tokens = count.second;
+
+		std::snprintf(line, sizeof(line), "%-32s %12.3f %12.3f %12llu %10llu\n", files[i].c_str(), wall, cpu,
+			(unsigned long long)allocs, (unsigned long long)tokens);
+		out << line;
+		total.Merge(report);
+	}
+
+	total.PrintText(out, "All files");
+	build.PrintText(out, "Build");
+}
+
+void TimeReport::PrintBuildJSON(std::ostream& out, const std::vector<std::string>& files, const std::vector<TimeReport>& reports, const TimeReport& build)
+{
+	TimeReport total;
+	out << "{\"files\":[";
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (i != 0)
+			out << ',';
+		out << "{\"file\":";
+		writeJSONString(out, files[i]);
+		out << ",\"report\":";
+		reports[i].WriteJSON(out);
+		out << '}';
+		total.Merge(reports[i]);
+	}
+	out << "],\"total\":";
+	total.WriteJSON(out);
+	out << ",\"build\":";
+	build.WriteJSON(out);
+	out << "}\n";
+}
+
+double TimeReport::getWallTimeMs()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+double TimeReport::getCPUTimeMs()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	// FILETIME counts 100ns ticks
+	auto ticks = [](const FILETIME& ft) { return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime; };
+	return (ticks(kernel) + ticks(user)) / 10000.0;
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+		return 0.0;
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+uint64_t TimeReport::getPeakRssKB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	// macOS reports bytes, Linux kilobytes
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+uint64_t TimeReport::getAllocationCount()
+{
+	std::lock_guard<std::mutex> lock(g_threadsMutex);
+	uint64_t count = g_exitedAllocations;
+	for (const ThreadAllocations* thread = g_threads; thread != nullptr; thread = thread->next)
+		count += thread->count.load(std::memory_order_relaxed);
+	return count;
+}
+
+double TimeReport::getThreadCPUTimeMs()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	auto ticks = [](const FILETIME& ft) { return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime; };
+	return (ticks(kernel) + ticks(user)) / 10000.0;
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0.0;
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+uint64_t TimeReport::getThreadAllocationCount()
+{
+	return t_allocations.count.load(std::memory_order_relaxed);
+}
+
+double TimeReport::readCPUTimeMs() const
+{
+	return m_perThread ? getThreadCPUTimeMs() : getCPUTimeMs();
+}
+
+uint64_t TimeReport::readAllocationCount() const
+{
+	return m_perThread ? getThreadAllocationCount() : getAllocationCount();
+}
@@ -0,0 +1,84 @@
+#include "headers/TokenStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+TokenStream::TokenStream(std::string_view source)
+	: m_source(source)
+{
+}
+
+std::vector<Token>& TokenStream::getTokens()
+{
+	return m_tokens;
+}
+
+const std::vector<Token>& TokenStream::getTokens() const
+{
+	return m_tokens;
+}
+
+size_t TokenStream::size() const
+{
+	return m_tokens.size();
+}
+
+const Token& TokenStream::operator[](size_t index) const
+{
+	return m_tokens[index];
+}
+
+std::string_view TokenStream::getSource() const
+{
+	return m_source;
+}
+
+std::string_view TokenStream::getText(const Token& token) const
+{
+	if (token.type == TokenType::STRING_LITERAL && token.literalIndex != 0)
+		return m_escapedLiterals[token.literalIndex - 1];
+	return m_source.substr(token.offset, token.length);
+}
+
+uint32_t TokenStream::AddEscapedLiteral(std::string&& literal)
+{
+	m_escapedLiterals.push_back(std::move(literal));
+	// 0 means "not escaped", so indices are stored off by one
+	return static_cast<uint32_t>(m_escapedLiterals.size());
+}
+
+size_t TokenStream::getLine(const Token& token) const
+{
+	return getLineOfOffset(token.offset);
+}
+
+size_t TokenStream::getColumn(const Token& token) const
+{
+	size_t line = getLine(token);
+	return token.offset - m_lineStarts[line - 1] + 1;
+}
+
+size_t TokenStream::getLineOfOffset(size_t offset) const
+{
+	if (m_lineStarts.empty())
+		BuildLineTable();
+
+	// Last line start that is <= offset
+	auto it = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), static_cast<uint32_t>(offset));
+	return static_cast<size_t>(it - m_lineStarts.begin());
+}
+
+void TokenStream::BuildLineTable() const
+{
+	m_lineStarts.push_back(0);
+
+	const char* begin = m_source.data();
+	const char* end = begin + m_source.size();
+	for (const char* p = begin; p < end; p++)
+	{
+		p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		if (p == nullptr)
+			break;
+		m_lineStarts.push_back(static_cast<uint32_t>(p + 1 - begin));
+	}
+}
@@ -1,227 +1,183 @@
 #include "headers/Tokenizer.h"
+#include "headers/Keywords.h"
 
-Tokenizer::Tokenizer(const std::string& program)
-	: m_index(0), m_currentLine(1), m_program(program) 
-{
-	// Data Types
-	m_builtinTypeMap["void"] = PrimitiveDataType::VOID;
-
-	m_builtinTypeMap["i8"]	 = PrimitiveDataType::i8;
-	m_builtinTypeMap["i16"]	 = PrimitiveDataType::i16;
-	m_builtinTypeMap["i32"]	 = PrimitiveDataType::i32;
-	m_builtinTypeMap["i64"]	 = PrimitiveDataType::i64;
-	m_builtinTypeMap["i128"] = PrimitiveDataType::i128;
-	
-	m_builtinTypeMap["u8"]   = PrimitiveDataType::u8;
-	m_builtinTypeMap["u16"]  = PrimitiveDataType::u16;
-	m_builtinTypeMap["u32"]  = PrimitiveDataType::u32;
-	m_builtinTypeMap["u64"]  = PrimitiveDataType::u64;
-	m_builtinTypeMap["u128"] = PrimitiveDataType::u128;
-	
-	m_builtinTypeMap["f32"]	 = PrimitiveDataType::f32;
-	m_builtinTypeMap["f64"]	 = PrimitiveDataType::f64;
-
-	// Keywords
-	m_keywordMap["return"]	= TokenType::RETURN;
-	m_keywordMap["let"]		= TokenType::LET;
-	m_keywordMap["fn"]		= TokenType::FN;
-	m_keywordMap["extern"]  = TokenType::EXTERN;
-
-	m_keywordMap["void"]= TokenType::BuiltinType;
-
-	m_keywordMap["i8"]  = TokenType::BuiltinType;
-	m_keywordMap["i16"] = TokenType::BuiltinType;
-	m_keywordMap["i32"] = TokenType::BuiltinType;
-	m_keywordMap["i64"] = TokenType::BuiltinType;
-	m_keywordMap["i128"]= TokenType::BuiltinType;
-
-	m_keywordMap["u8"]  = TokenType::BuiltinType;
-	m_keywordMap["u16"] = TokenType::BuiltinType;
-	m_keywordMap["u32"] = TokenType::BuiltinType;
-	m_keywordMap["u64"] = TokenType::BuiltinType;
-	m_keywordMap["u128"]= TokenType::BuiltinType;
-
-	m_keywordMap["f32"] = TokenType::BuiltinType;
-	m_keywordMap["f64"] = TokenType::BuiltinType;
+#include <climits>
 
-	// Symbols
-	m_symbolMap["("]	= TokenType::LParan;
-	m_symbolMap[")"]	= TokenType::RParan;
-	m_symbolMap["{"]	= TokenType::LCURLY;
-	m_symbolMap["}"]	= TokenType::RCURLY;
-	m_symbolMap[":"]	= TokenType::COLON;
-	m_symbolMap[";"]	= TokenType::SEMICOLON;
-	m_symbolMap["="]	= TokenType::EQUALS;
-	m_symbolMap["=="]	= TokenType::EQUALITY;
-	m_symbolMap["+"]	= TokenType::PLUS;
-	m_symbolMap["-"]	= TokenType::MINUS;
-	m_symbolMap["->"]	= TokenType::ARROW;
-	m_symbolMap["*"]	= TokenType::STAR;
-	m_symbolMap["/"]	= TokenType::FORWARD_SLASH;
-	m_symbolMap["%"]	= TokenType::MODULUS;
-	m_symbolMap["..."]	= TokenType::ELLIPSIS;
-	m_symbolMap[","]	= TokenType::COMMA;
+Tokenizer::Tokenizer(std::string_view program, StringInterner& interner)
+	: m_index(0), m_currentLine(1), m_program(program), m_interner(interner), m_scan(getScanFunctions()), m_stream(program)
+{
 }
 
 bool Tokenizer::Tokenize()
 {
-	while (peek().has_value())
+	// Tokens store 32 bit offsets
+	if (m_program.size() > UINT32_MAX)
+	{
+		Logger::fmtLog(LogLevel::Error, "Source file is too large (%zu bytes)", m_program.size());
+		return false;
+	}
+
+	const char* begin = m_program.data();
+	const char* end = begin + m_program.size();
+
+	while (m_index < m_program.size())
 	{
-		if (std::isalpha(peek().value()))
+		const char* p = begin + m_index;
+		char c = *p;
+
+		if (isAlphaChar(c))
 		{
 			// readWord will automatically consume the characters
-			std::string word(std::move(readWord()));
+			std::string_view word = readWord();
 
-			std::optional<TokenType> res = keywordExist(word);
-			if (res.has_value()) {
-				if(isDataType(word))
-					m_tokens.emplace_back(res.value(), word, m_currentLine, m_builtinTypeMap[word]);
-				else 
-					m_tokens.emplace_back(res.value(), word, m_currentLine);
-			}
+			WordClass wordClass = classifyWord(word);
+			if (wordClass.type != TokenType::IDENT)
+				AddToken(wordClass.type, word.data(), word.size(), wordClass.dataType);
 			else /* Its an IDENTifier */
-				m_tokens.emplace_back(TokenType::IDENT, word, m_currentLine);
+				AddToken(TokenType::IDENT, word.data(), word.size(), PrimitiveDataType::EMPTY, m_interner.Intern(word));
 		}
-		else if (std::isdigit(peek().value()))
+		else if (isDigitChar(c))
 		{
-			std::string buffer;
-			buffer.reserve(32);
+			const char* numEnd = m_scan.skipDigits(p + 1, end);
 
-			while (peek().has_value() && std::isdigit(peek().value()))
-				buffer.push_back(consume());
-
-			if (peek().has_value() && peek().value() == '.')
-				buffer.push_back(consume());
-			else
+			// "0..n" is an integer followed by a range
+			if (numEnd == end || *numEnd != '.' || (numEnd + 1 < end && numEnd[1] == '.'))
 			{
-				m_tokens.emplace_back(TokenType::INT_LITERAL, buffer, m_currentLine);
+				AddToken(TokenType::INT_LITERAL, p, numEnd - p);
+				m_index = numEnd - begin;
 				continue;
 			}
 	
 			// Atleast 1 number should be there after .
-			if (peek().has_value() && std::isdigit(peek().value()))
-				buffer.push_back(consume());
-			else
+			if (numEnd + 1 == end || !isDigitChar(numEnd[1]))
 			{
 				Logger::fmtLog(LogLevel::Error, "Atleast 1 digit should be present after '.'");
 				return false;
 			}
-			while (peek().has_value() && std::isdigit(peek().value()))
-				buffer.push_back(consume());
-			m_tokens.emplace_back(TokenType::FLOAT_LITERAL, buffer, m_currentLine);
+
+			numEnd = m_scan.skipDigits(numEnd + 2, end);
+			AddToken(TokenType::FLOAT_LITERAL, p, numEnd - p);
+			m_index = numEnd - begin;
 		}
-		else if (peek().value() == '/' && (peek(1).has_value() && peek(1).value() == '/'))
+		else if (isSpaceChar(c))
 		{
-			consume();
-			if (peek().has_value() && peek().value() == '/')
-			{
-				while (peek().has_value() && peek().value() != '\n')
-					consume();
-				//To consume the newline character;
-				m_currentLine += 1;
-				consume();
-			}
+			size_t newlines = 0;
+			m_index = m_scan.skipWhitespace(p, end, newlines) - begin;
+			m_currentLine += newlines;
 		}
-		else if (peek().value() == '/' && (peek(1).has_value() && peek(1).value() == '*'))
+		else if (c == '/' && p + 1 < end && p[1] == '/')
 		{
-			bool toBreak = false;
-			while (!toBreak && peek().has_value())
-			{
-				if (peek().value() == '*' && peek(1).has_value() && peek(1).value() == '/')
-				{
-					toBreak = true;
-					//Cosume *
-					consume();
-					//Consume /
-					consume();
-					break;
-				}
-				if (consume() == '\n')
-					m_currentLine += 1;
-			}
+			// The newline itself is left for the whitespace branch
+			m_index = m_scan.findLineEnd(p + 2, end) - begin;
+		}
+		else if (c == '/' && p + 1 < end && p[1] == '*')
+		{
+			size_t newlines = 0;
+			const char* commentEnd = m_scan.findBlockCommentEnd(p + 2, end, newlines);
+			m_currentLine += newlines;
+
+			// Skip the closing "*/"
+			m_index = commentEnd == end ? m_program.size() : commentEnd + 2 - begin;
 		}
-		else if (isSymbol(peek().value()))
+		else if (isSymbol(c))
 		{
-			std::string buf;
-			buf.push_back(consume());
+			size_t length = 1;
 			
-			if (peek().has_value())
+			if (p + 1 < end)
 			{
-				if (buf == "-" && peek().value() == '>')
-					buf.push_back(consume());
-				else if (buf == "=" && peek().value() == '=')
-					buf.push_back(consume());
-				else if (buf == "." && peek().value() == '.' && (peek(1).has_value() && peek(1).value() == '.'))
-				{
-					buf.push_back(consume(/*Consume the '.'*/));
-					buf.push_back(consume(/*Consume the '.'*/));
-				}
+				if (c == '-' && p[1] == '>')
+					length = 2;
+				else if ((c == '=' || c == '!' || c == '<' || c == '>') && p[1] == '=')
+					length = 2;
+				else if (c == '.' && p[1] == '.')
+					length = (p + 2 < end && p[2] == '.') ? 3 : 2;
 			}
 
+			std::string_view buf(p, length);
+			m_index += length;
 
-			auto it = m_symbolMap.find(buf);
-			if (it != m_symbolMap.end())
-				m_tokens.emplace_back(it->second, buf, m_currentLine);
+			std::optional<TokenType> symbol = classifySymbol(buf);
+			if (symbol.has_value())
+				AddToken(symbol.value(), p, length);
 			else
 			{
-				Logger::fmtLog(LogLevel::Error, "Invalid symbol found '%s' on line: %lu", buf, m_currentLine);
+				Logger::fmtLog(LogLevel::Error, "Invalid symbol found '%.*s' on line: %lu", (int)buf.size(), buf.data(), m_currentLine);
 				return false;
 			}
 		}
-		else if (peek().value() == '\"')
+		else if (c == '\"')
 		{
-			consume();
-
 			// String Literal
+			// Literals without escape sequences are read straight from the source,
+			// only escaped ones need their own storage
+			size_t startLine = m_currentLine;
+			const char* start = p + 1;
+			bool escaped = false;
 			std::string buffer;
-			buffer.reserve(256);
 
-			while (peek().has_value() && peek().value() != '\"')
+			p = start;
+			while (true)
 			{
-				if (peek().value() == '\\') 
+				size_t newlines = 0;
+				const char* special = m_scan.findStringSpecial(p, end, newlines);
+				m_currentLine += newlines;
+
+				if (escaped)
+					buffer.append(p, special - p);
+				p = special;
+
+				if (p == end)
 				{
-					// Escape Sequence
-					consume();
-					if (peek().has_value())
-						switch (consume())
-						{
-						case 'n':
-							buffer.push_back('\n');
-							break;
-						case 't':
-							buffer.push_back('\n');
-							break;
-						case '\"':
-							buffer.push_back('\"');
-							break;
-						case '0':
-							buffer.push_back('\0');
-							break;
-						default:
-							Logger::fmtLog("Invalid escape sequence found '%c' on line: %ld", peek(-1).value(), m_currentLine);
-							return false;
-						}
+					Logger::fmtLog(LogLevel::Error, "Unterminated string literal starting on line: %lu", startLine);
+					return false;
+				}
+				if (*p == '\"')
+					break;
 
-					else
-					{
-						Logger::fmtLog(LogLevel::Error, "Expected a escape sequence after '\\' on line: %ld", m_currentLine);
-						return false;
-					}
+				// Escape Sequence
+				if (!escaped)
+				{
+					escaped = true;
+					buffer.reserve(256);
+					buffer.assign(start, p - start);
+				}
+
+				if (p + 1 == end)
+				{
+					Logger::fmtLog(LogLevel::Error, "Expected a escape sequence after '\\' on line: %ld", m_currentLine);
+					return false;
 				}
-				else
-					buffer.push_back(consume());
+
+				switch (p[1])
+				{
+				case 'n':
+					buffer.push_back('\n');
+					break;
+				case 't':
+					buffer.push_back('\t');
+					break;
+				case '\"':
+					buffer.push_back('\"');
+					break;
+				case '0':
+					buffer.push_back('\0');
+					break;
+				default:
+					Logger::fmtLog(LogLevel::Error, "Invalid escape sequence found '%c' on line: %ld", p[1], m_currentLine);
+					return false;
+				}
+				p += 2;
 			}
-			consume();
-			m_tokens.emplace_back(TokenType::STRING_LITERAL, buffer, m_currentLine, PrimitiveDataType::str);
-		}
-		else if (std::isspace(peek().value()))
-		{
-			if (consume() == '\n')
-				m_currentLine += 1;
+
+			uint32_t literalIndex = escaped ? m_stream.AddEscapedLiteral(std::move(buffer)) : 0;
+			AddToken(TokenType::STRING_LITERAL, start, p - start, PrimitiveDataType::str, literalIndex);
+
+			// Skip the closing '"'
+			m_index = p + 1 - begin;
 		}
 		else
 		{
-			Logger::fmtLog(LogLevel::Error, "Invalid character found '%c' on line: %lu", peek().value(), m_currentLine);
+			Logger::fmtLog(LogLevel::Error, "Invalid character found '%c' on line: %lu", c, m_currentLine);
 			return false;
 		}
 	}
@@ -229,51 +185,25 @@ bool Tokenizer::Tokenize()
 	return true;
 }
 
-std::vector<Token>& Tokenizer::getTokens()
-{
-	std::string eofStr = "$";
-	m_tokens.push_back(Token(TokenType::_EOF, eofStr, INT_MAX));
-	return m_tokens;
-}
-
-std::string Tokenizer::readWord()
-{
-	std::string buffer;
-	buffer.reserve(16);
-
-	while (peek().has_value() && std::isalnum(peek().value()))
-		buffer.push_back(consume());
-
-	return buffer;
-}
-
-std::optional<char> Tokenizer::peek(size_t ahead)
-{
-	size_t lookAt = m_index + ahead;
-	if (lookAt < m_program.size())
-		return m_program[lookAt];
-	return {};
-}
-
-char Tokenizer::consume()
+TokenStream& Tokenizer::getTokens()
 {
-	return m_program[m_index++];
+	m_stream.getTokens().emplace_back(TokenType::_EOF, static_cast<uint32_t>(m_program.size()), 0);
+	return m_stream;
 }
 
-
-bool Tokenizer::isDataType(const std::string& key)
+void Tokenizer::AddToken(TokenType type, const char* start, size_t length, PrimitiveDataType dataType, uint32_t payload)
 {
-	return m_keywordMap[key] == TokenType::BuiltinType;
+	uint32_t offset = static_cast<uint32_t>(start - m_program.data());
+	m_stream.getTokens().emplace_back(type, offset, static_cast<uint32_t>(length), dataType, payload);
 }
 
-std::optional<TokenType> Tokenizer::keywordExist(const std::string& key)
+std::string_view Tokenizer::readWord()
 {
-	auto it = m_keywordMap.find(key);
+	const char* start = m_program.data() + m_index;
+	const char* wordEnd = m_scan.skipAlnum(start, m_program.data() + m_program.size());
+	m_index = wordEnd - m_program.data();
 
-	if (it != m_keywordMap.end())
-		return it->second;
-	
-	return {};
+	return std::string_view(start, wordEnd - start);
 }
 
 bool Tokenizer::isSymbol(char c)
@@ -284,6 +214,8 @@ bool Tokenizer::isSymbol(char c)
 		case ')':
 		case '{':
 		case '}':
+		case '[':
+		case ']':
 		case ';':
 		case '-':
 		case '+':
@@ -291,6 +223,8 @@ bool Tokenizer::isSymbol(char c)
 		case '*':
 		case '%':
 		case '>':
+		case '<':
+		case '!':
 		case ':':
 		case '=':
 		case '.':
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed size array living in an Arena
+template<typename T>
+struct ArenaSpan
+{
+	T* data = nullptr;
+	uint32_t count = 0;
+
+	T* begin() const { return data; }
+	T* end() const { return data + count; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T& operator[](size_t index) const { return data[index]; }
+};
+
+// Bump allocator, everything allocated from it is released at once when the arena dies.
+// Destructors are never run, so only trivially destructible types may be placed in it.
+class Arena
+{
+public:
+	explicit Arena(size_t blockSize = 64 * 1024);
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* Allocate(size_t size, size_t align);
+
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+		m_objectCount++;
+		return new (Allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+	}
+
+	// Copies [first, last) into the arena
+	template<typename T>
+	ArenaSpan<T> CopyArray(const T* first, const T* last)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Arena arrays are copied with memcpy");
+		ArenaSpan<T> span;
+		span.count = static_cast<uint32_t>(last - first);
+		if (span.count == 0)
+			return span;
+
+		span.data = static_cast<T*>(Allocate(sizeof(T) * span.count, alignof(T)));
+		std::memcpy(span.data, first, sizeof(T) * span.count);
+		return span;
+	}
+
+	// Copies the elements of scratch from `start` onwards and removes them from scratch,
+	// lets nested lists share one scratch vector
+	template<typename T>
+	ArenaSpan<T> TakeTail(std::vector<T>& scratch, size_t start)
+	{
+		ArenaSpan<T> span = CopyArray(scratch.data() + start, scratch.data() + scratch.size());
+		scratch.resize(start);
+		return span;
+	}
+
+	std::string_view CopyString(std::string_view str);
+
+	size_t getBytesUsed() const;
+	size_t getBlockCount() const;
+	size_t getObjectCount() const;
+
+private:
+	void NewBlock(size_t minSize);
+
+	size_t m_blockSize;
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	char* m_cursor = nullptr;
+	char* m_blockEnd = nullptr;
+
+	size_t m_bytesUsed = 0;
+	size_t m_objectCount = 0;
+};
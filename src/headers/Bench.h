@@ -0,0 +1,7 @@
+#pragma once
+#include "Options.h"
+
+// `veritas bench <kind>`: times the front end on the input files, or on a program generated
+// to options.benchSize when none are given, and prints its throughput to stdout.
+// With -o the generated program is written there instead of being measured.
+int RunBenchmark(const CompileOptions& options);
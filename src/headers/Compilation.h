@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CompileCache.h"
+#include "Interner.h"
+#include "Node.h"
+#include "Options.h"
+#include "ShardedGenerator.h"
+#include "SourceFile.h"
+#include "TimeReport.h"
+
+// One translation unit taken through every phase of the compiler.
+// Compilations share nothing, so several of them can run on different threads.
+class Compilation
+{
+public:
+	// Phases are recorded into report, which has to outlive the compilation. cache may be null
+	Compilation(const CompileOptions& options, const std::string& inputPath, TimeReport& report, CompileCache* cache = nullptr);
+
+	// Reads, tokenizes, parses, generates, verifies and optimizes the module.
+	// On a cache hit the outputs are written right after reading and every other phase is skipped.
+	bool BuildModule(const std::string& outputPath);
+
+	// Writes the output of options.emit to outputPath. An executable is not linked here:
+	// its object files are written next to outputPath and appended to objects instead.
+	bool Emit(const std::string& outputPath, std::vector<std::string>& objects);
+
+	// JIT compiles the module and calls main, returns the exit code of the program or -1
+	int Run(const std::vector<std::string>& programArgs);
+
+	const std::string& getInputPath() const;
+
+private:
+	bool EmitOutputs(const std::string& outputPath, std::vector<std::string>& objects);
+
+private:
+	const CompileOptions& m_options;
+	std::string m_inputPath;
+	TimeReport& m_report;
+	CompileCache* m_cache;
+	uint64_t m_cacheKey = 0;
+	bool m_cacheHit = false;
+	std::vector<std::string> m_cachedFiles;
+
+	// Literals and the interned names of the program point into these, they live as long as it
+	SourceFile m_source;
+	StringInterner m_interner;
+	std::unique_ptr<Program> m_program;
+	std::unique_ptr<ShardedGenerator> m_generator;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <llvm/Support/CachePruning.h>
+
+#include "Options.h"
+
+// On-disk cache of compiler outputs, keyed by a hash of the source bytes, the compiler binary
+// and every option that changes the output. An unchanged file then costs a read and a hash.
+// Entries are single files named llvmcache-<key>, which is what llvm::pruneCache evicts by.
+// Safe to use from several compilations, and several processes, at the same time.
+class CompileCache
+{
+public:
+	CompileCache(const std::string& directory, const llvm::CachePruningPolicy& policy);
+
+	// Creates the directory and identifies the running compiler
+	bool Init();
+
+	uint64_t ComputeKey(std::string_view source, const CompileOptions& options, const std::string& inputPath) const;
+
+	// On a hit writes the cached outputs of the entry back, named like when they were stored, and returns their paths
+	bool Fetch(uint64_t key, const std::string& outputPath, std::vector<std::string>& files);
+
+	// Every file has to be outputPath itself or outputPath followed by a suffix
+	bool Store(uint64_t key, const std::string& outputPath, const std::vector<std::string>& files);
+
+	// Evicts the least recently used entries past the size limits of the policy
+	void Prune();
+
+	void PrintStats(std::ostream& out) const;
+
+private:
+	std::string getEntryPath(uint64_t key) const;
+
+	std::string m_directory;
+	llvm::CachePruningPolicy m_policy;
+	// Path, size and modification time of the veritas executable, a rebuilt compiler misses every entry
+	std::string m_compilerID;
+
+	std::atomic<uint64_t> m_hits{ 0 };
+	std::atomic<uint64_t> m_misses{ 0 };
+	std::atomic<uint64_t> m_bytesServed{ 0 };
+	std::atomic<uint64_t> m_bytesStored{ 0 };
+};
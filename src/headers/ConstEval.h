@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <llvm/ADT/APFloat.h>
+#include <llvm/ADT/APInt.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/IR/Constants.h>
+
+#include "Interner.h"
+#include "Node.h"
+
+// Bounds of a single constant evaluation, an endless or runaway const fn is reported instead of hanging the build
+struct ConstEvalLimits
+{
+	// Statements executed, loop iterations and expression nodes evaluated
+	uint64_t maxSteps = 10'000'000;
+	// Bytes of locals, temporaries and call frames alive at the same time
+	uint64_t maxMemory = 64ull * 1024 * 1024;
+};
+
+// A value computed at compile time. Integers of either signedness are stored by width, they compute the same
+struct ConstValue
+{
+	PrimitiveDataType type = PrimitiveDataType::EMPTY;	// i1, i8 to i128, f32 or f64
+	llvm::APInt intValue;
+	llvm::APFloat floatValue = llvm::APFloat(0.0);
+	// Of an unsigned type, which is only told apart when the value is widened or converted to a float
+	bool isUnsigned = false;
+};
+
+// Interprets `const` initializers and the `const fn`s they call over the AST. Arithmetic and the implicit
+// casts follow what Generator emits for the same code, so a constant is exactly what the program would
+// have computed at run time. Anything the program could not compute (division by zero, a float that does
+// not fit an integer) is an error.
+class ConstEvaluator
+{
+public:
+	// Gives the value of a name that is not a local of the const fn being run, false if it is not a constant.
+	// Inside a const fn only globals are in scope, globalOnly then asks to skip the locals of the caller
+	using Resolver = llvm::function_ref<bool(SymbolID id, bool globalOnly, ConstValue& value)>;
+
+	ConstEvaluator(const Program& program, const StringInterner& interner, const ConstEvalLimits& limits);
+
+	// Evaluates expr and converts it to type. Returns false after logging why it is not a constant
+	bool Evaluate(const Expr* expr, PrimitiveDataType type, Resolver resolve, ConstValue& result);
+
+	static llvm::Constant* toConstant(const ConstValue& value, llvm::LLVMContext& ctx);
+	// False for constants of types the evaluator does not handle, e.g. pointers
+	static bool fromConstant(const llvm::Constant* constant, ConstValue& value);
+
+private:
+	enum class Flow : uint8_t
+	{
+		Next,
+		Return,
+		Fail,
+	};
+
+	struct Local
+	{
+		SymbolID name;
+		ConstValue value;
+		bool isLoopVariable = false;
+	};
+
+	bool EvaluateExpr(const Expr* expr, ConstValue& result);
+	bool Call(const FnCall* call, ConstValue& result);
+	Flow ExecuteBlock(const CompoundStmt* block, ConstValue& returnValue);
+	Flow ExecuteStatement(const Stmt* stmt, ConstValue& returnValue);
+
+	bool Step();
+	bool Charge(uint64_t bytes);
+	void Release(uint64_t bytes);
+	Local* FindLocal(SymbolID name);
+
+	const StringInterner& m_interner;
+	ConstEvalLimits m_limits;
+	llvm::DenseMap<SymbolID, const FnStmt*> m_functions;
+
+	// Set for the duration of Evaluate
+	Resolver m_resolve = nullptr;
+	uint64_t m_steps = 0;
+	uint64_t m_memory = 0;
+
+	// Locals of every active call, m_frameBase is where those of the innermost one start
+	std::vector<Local> m_locals;
+	size_t m_frameBase = 0;
+	size_t m_callDepth = 0;
+};
@@ -0,0 +1,9 @@
+#pragma once
+#include "Node.h"
+
+// Replaces every operator whose operands are all literals by the literal it evaluates to, e.g. `9.22 * 2`
+// becomes 18.44, so constant expressions never reach the IRBuilder and globals get plain initializers.
+// Values are computed exactly like the instructions Generator would emit, including its implicit casts,
+// anything that would not be (division by zero, a non finite result) is left for run time.
+// Returns the number of expression nodes removed.
+size_t FoldConstants(Program& program);
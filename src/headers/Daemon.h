@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+#include "Options.h"
+
+// $XDG_RUNTIME_DIR/veritasd.sock, or /tmp/veritasd-<uid>.sock when that is not set
+std::string getDefaultSocketPath();
+
+// Serves compile requests on options.socketPath until killed. Targets are registered and the
+// thread pool started once, every request then only pays for its own files. Returns the exit code.
+int RunDaemon(const CompileOptions& options);
+
+// Sends the command line to a running daemon and prints its diagnostics and reports as if the build
+// ran here. Returns false when no daemon answered, the caller then compiles in-process.
+bool CompileWithDaemon(const CompileOptions& options, int argc, char* argv[], int& exitCode);
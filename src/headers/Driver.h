@@ -0,0 +1,14 @@
+#pragma once
+#include <ostream>
+
+#include <llvm/Support/ThreadPool.h>
+
+#include "Options.h"
+
+// Compiles every input file and links them for --emit=exe. Files run on pool when one is
+// given, as veritasd does, otherwise on a pool of -j threads created for the build.
+// Time reports and cache statistics go to reportOut. Returns the exit code of veritas.
+int BuildFiles(const CompileOptions& options, std::ostream& reportOut, llvm::ThreadPool* pool = nullptr);
+
+// `veritas run`: compiles the single input file and runs it, returns the exit code of the program
+int RunFile(const CompileOptions& options, std::ostream& reportOut);
@@ -5,74 +5,182 @@
 #include <string>
 #include "llvm_includes.h"
 
+#include "ConstEval.h"
 #include "Node.h"
+#include "Interner.h"
 #include "Parser.h"
+#include "Options.h"
+#include "SSABuilder.h"
+#include "SymbolTable.h"
 #include "token.h"
 
-struct varInfo
-{
-	llvm::Value* vAddr = nullptr;
-	llvm::Type* vType = nullptr;
-};
-
 struct fnInfo
 {
+	llvm::Function* fn = nullptr;
 	llvm::FunctionType* fnType = nullptr;
+	const FnStmt* fnStmt = nullptr;
 	bool isDefined = false;
 };
 
+// Functions implemented by the generator, a function of the program with the same name takes precedence
+enum class Builtin : uint8_t
+{
+	Length,		// len(array or slice)
+	Shuffle,	// shuffle(a, [b,] lanes...)
+	ReduceAdd,	// reduceAdd(vector) and the other reductions fold all lanes into a scalar
+	ReduceMul,
+	ReduceMin,
+	ReduceMax,
+};
+
 class Generator
 {
 public:
-	Generator(std::unique_ptr<Program> program, const std::string& moduleName, const std::string& outPath);
-	void Generate();
+	Generator(const Program& program, StringInterner& interner, const std::string& moduleName, const std::string& outPath);
+	// Builds the module, returns false if a declaration could not be generated
+	bool Generate();
+
+	// Makes Generate define only the functions flagged in definedFunctions (indexed like Program::FnStmts)
+	// and the globals if definesGlobals, everything else is declared so it links against the other shards
+	void SetShard(std::vector<bool> definedFunctions, bool definesGlobals);
+
+	// Bounds for evaluating `const` declarations, the defaults of ConstEvalLimits otherwise
+	void SetConstEvalLimits(const ConstEvalLimits& limits);
+
+	bool VerifyModule() const;
+
+	// Registers every LLVM target, done once per process by the first InitTarget or up front by the daemon
+	static void InitializeTargets();
 
-	llvm::Value* CreateGlobalDecl(const std::unique_ptr<DeclStmt>& declStmt);
+	// Sets the module's triple and data layout from the options and creates the target machine used to emit code
+	bool InitTarget(const CompileOptions& options);
 
-	llvm::Function* CreateFunction(const std::unique_ptr<FnStmt>& fnStmt);
+	bool EmitMachineCode(const std::string& path, llvm::CodeGenFileType fileType);
+
+	// Runs the standard new pass manager pipeline of the given level over the module
+	void OptimizeModule(OptLevel level, bool verifyEach);
+
+	void PrintModule(llvm::raw_ostream& out) const;
+
+	size_t getInstructionCount() const;
+
+	llvm::Value* CreateGlobalDecl(const DeclStmt* declStmt);
+
+	// Initializer of a `const` or global computed while compiling, nullptr after logging why it is not a constant
+	llvm::Constant* EvaluateConstant(const DeclStmt* declStmt);
+
+	// Without define only the prototype is added to the module
+	llvm::Function* CreateFunction(const FnStmt* fnStmt, bool define = true);
 	
-	llvm::CallInst* CreateFunctionCall(const std::unique_ptr<FnCall>& FunctionCall);
+	// Lowers the FnAttribute flags of fnStmt, nounwind for every function with a Veritas body and the
+	// qualifiers of pointer and slice parameters
+	void AddFunctionAttributes(llvm::Function* fn, const FnStmt* fnStmt);
+
+	// Fails after logging if the generated body of a pure function writes memory or calls an impure function,
+	// otherwise marks it readnone when it reads no memory either
+	bool CheckPureFunction(llvm::Function* fn, const FnStmt* fnStmt);
+
+	llvm::CallInst* CreateFunctionCall(const FnCall* FunctionCall);
+
+	// Both return false after logging the first statement that could not be generated
+	bool GenerateCompoundStatement(const CompoundStmt* cmpndStmt);
 
-	void GenerateCompoundStatement(const std::unique_ptr<CompoundStmt>& cmpndStmt);
+	bool GenerateStatement(const Stmt* stmt);
 
-	void GenerateStatement(const std::unique_ptr<Stmt>& stmt);
+	// Canonical loop: preheader, header testing the counter, body, a single latch and a dedicated exit
+	bool GenerateForStatement(const ForStmt* forStmt);
 
-	llvm::Value* GenerateExpr(const std::unique_ptr<Expr>& expr);
+	// Marks a loop's back edge, see GenerateForStatement
+	llvm::MDNode* CreateLoopMetadata();
 
-	void saveModuleToFile() const;
+	// isUnsigned, if given, receives whether the value is of an unsigned type
+	llvm::Value* GenerateExpr(const Expr* expr, bool* isUnsigned = nullptr);
+
+	llvm::Value* GenerateBinaryOp(TokenType op, llvm::Value* LHS, llvm::Value* RHS, bool lhsUnsigned, bool rhsUnsigned, bool isUnsigned);
+
+	llvm::Value* GenerateUnaryOp(TokenType op, llvm::Value* operand);
+
+	llvm::Value* GenerateLiteral(const Literal* lit);
+
+	// Address of name[index], elementType receives the type stored there. nullptr after logging if name is no array or slice
+	llvm::Value* GenerateElementAddress(SymbolID name, llvm::Value* index, bool indexUnsigned, llvm::Type*& elementType);
+
+	// Value of a variable that is no array or slice
+	llvm::Value* ReadVariable(const varInfo* vInfo, SymbolID name);
+
+	// Lane index of a vector as an i64, nullptr after logging if it is a constant out of range
+	llvm::Value* GenerateLaneIndex(llvm::FixedVectorType* vectorType, llvm::Value* index, bool indexUnsigned);
+
+	// The builtin called by name, nullptr if there is none or the program defines a function of that name
+	const Builtin* findBuiltin(SymbolID name) const;
+
+	llvm::Value* GenerateBuiltinCall(const FnCall* call, Builtin builtin);
+
+	// Alignment of a global or local array
+	llvm::Align getArrayAlignment(llvm::Type* arrayType) const;
+
+	// Makes sure the array or slice passed to an align(N) parameter is aligned to N, raising a local array's alignment.
+	// Returns false after logging otherwise
+	bool CheckAlignment(const varInfo* vInfo, SymbolID name, uint32_t alignment);
+
+	// The builtin len(array or slice), an i64
+	llvm::Value* GenerateLength(const FnCall* call);
+
+	// Lanes picked by constant indices from one vector, or from two of the same type where b's lanes follow a's
+	llvm::Value* GenerateShuffle(const FnCall* call);
+
+	// Horizontal add, mul, min or max of a vector's lanes, float lanes are added and multiplied in any order
+	llvm::Value* GenerateReduction(const FnCall* call, Builtin builtin);
+
+	bool saveModuleToFile() const;
+
+	bool saveBitcodeToFile() const;
+
+	// Hands the module and its context over, e.g. to the JIT, the generator is unusable afterwards
+	llvm::orc::ThreadSafeModule takeModule();
 
 	void moduleInit();
 
 	int getTypePriority(llvm::Type* type);
 
-	llvm::Value* autoTypeCast(llvm::Value* val, llvm::Type* targetType) const;
+	// isUnsigned tells whether an integer val is of an unsigned type, it is then zero extended instead of sign extended.
+	// targetUnsigned does the same for targetType, a float is then converted with fptoui
+	llvm::Value* autoTypeCast(llvm::Value* val, llvm::Type* targetType, bool isUnsigned = false, bool targetUnsigned = false) const;
 
 	llvm::Type* findTypeFromPrimitive(PrimitiveDataType pdt);
 
+	llvm::StringRef getName(SymbolID id) const;
+
 public:
 	std::string m_outPath;
 	std::string m_moduleName;
-	std::unique_ptr<Program> m_program;
+	const Program& m_program;
+	// Set by SetShard, empty when this generator builds the whole program
+	std::vector<bool> m_definedFunctions;
+	bool m_definesGlobals = true;
+	StringInterner& m_interner;
 	llvm::FunctionType* m_FunctionType;
+	// The function being generated returns an unsigned integer
+	bool m_returnsUnsigned = false;
+
+	// Names the generator has to recognize, interned once up front
+	SymbolID m_mainSymbol;
+	SymbolID m_printfSymbol;
+	llvm::DenseMap<SymbolID, Builtin> m_builtins;
 
 	std::unique_ptr<llvm::LLVMContext> ctx;
 	std::unique_ptr<llvm::Module> cModule;
 	std::unique_ptr<llvm::IRBuilder<>> builder;
+	std::unique_ptr<llvm::TargetMachine> m_targetMachine;
 	
-	/* TODO: Replace current finding of symbol with name with ident and scope
-	struct VarID
-	{
-		std::string scope;
-		std::string ident;
-	};
-
-	and we keep a stack which keeps track of current scope
-	and we try to find var with all scopes in that stack
-	global scope: "GLOBAL"
-	or rather the key of map should be string(ident) + ':' + string(scopeName)
-	*/
-
 	std::unordered_map<PrimitiveDataType, llvm::Type*> m_TypeMap;
-	std::unordered_map<std::string, varInfo> m_symbolMap;
-	std::unordered_map<std::string, fnInfo> m_FunctionMap;
+	// Globals, then the parameters and locals of the function being generated
+	SymbolTable m_symbols;
+	// Global consts, the only names a const fn sees besides its own locals
+	llvm::DenseMap<SymbolID, varInfo> m_globalConstants;
+	ConstEvalLimits m_constEvalLimits;
+	// Created by the first const, most programs have none
+	std::unique_ptr<ConstEvaluator> m_constEvaluator;
+	SSABuilder m_ssa;
+	std::unordered_map<SymbolID, fnInfo> m_FunctionMap;
 };
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Every distinct identifier of a compilation is mapped to a small integer once,
+// after that it is only ever compared/hashed as an integer.
+using SymbolID = uint32_t;
+constexpr SymbolID INVALID_SYMBOL = 0;
+
+class StringInterner
+{
+public:
+	StringInterner();
+
+	StringInterner(const StringInterner&) = delete;
+	StringInterner& operator=(const StringInterner&) = delete;
+
+	// Returns the id of str, interning it on first sight
+	SymbolID Intern(std::string_view str);
+	// Returns INVALID_SYMBOL if str was never interned
+	SymbolID find(std::string_view str) const;
+
+	// Interned strings are null terminated, so data() can be passed to C apis
+	std::string_view getString(SymbolID id) const;
+	size_t size() const;
+
+private:
+	const char* CopyToArena(std::string_view str);
+	void Rehash(size_t newCapacity);
+	static uint32_t hash(std::string_view str);
+
+	static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+	// Arena holding the characters of every interned string
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	char* m_cursor = nullptr;
+	size_t m_remaining = 0;
+
+	// Indexed by SymbolID
+	std::vector<std::string_view> m_strings;
+	std::vector<uint32_t> m_hashes;
+
+	// Open addressing table of SymbolIDs, capacity is always a power of 2
+	std::vector<SymbolID> m_table;
+};
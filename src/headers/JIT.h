@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Target/TargetMachine.h>
+
+// Compiles a module in memory and runs its main in this process, used by `veritas run`.
+// extern functions are resolved against the symbols of the running process, so printf
+// and friends come from the C runtime veritas itself is linked with.
+class JIT
+{
+public:
+	// Lazy compiles every function on its first call instead of the whole module up front,
+	// with compileThreads above 0 modules are compiled concurrently on that many threads
+	bool Init(const llvm::TargetMachine& targetMachine, bool lazy, unsigned compileThreads);
+
+	// One of the modules added has to define main
+	bool AddModule(llvm::orc::ThreadSafeModule module);
+
+	// Looks up main, which compiles the module unless the JIT is lazy
+	bool LookupMain();
+
+	// Calls main with argc/argv built from the program name and arguments, returns its exit code
+	int RunMain(const std::string& programName, const std::vector<std::string>& args);
+
+private:
+	std::unique_ptr<llvm::orc::LLJIT> m_jit;
+	llvm::orc::LLLazyJIT* m_lazyJIT = nullptr;
+	llvm::JITTargetAddress m_mainAddress = 0;
+	bool m_hasMain = false;
+	bool m_mainReturnsVoid = false;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <string_view>
+#include <optional>
+
+#include "token.h"
+
+// Classification of words and symbols is done with switches on the lexeme length
+// and its characters, so it costs a handful of compares and needs no tables to be
+// built at runtime.
+
+struct WordClass
+{
+	TokenType type;
+	PrimitiveDataType dataType;
+};
+
+constexpr PrimitiveDataType classifyIntWidth(char sign, char hi, char lo)
+{
+	// sign: 'i' or 'u', hi/lo: the two digits of the width
+	bool isSigned = sign == 'i';
+	if (hi == '1' && lo == '6') return isSigned ? PrimitiveDataType::i16 : PrimitiveDataType::u16;
+	if (hi == '3' && lo == '2') return isSigned ? PrimitiveDataType::i32 : PrimitiveDataType::u32;
+	if (hi == '6' && lo == '4') return isSigned ? PrimitiveDataType::i64 : PrimitiveDataType::u64;
+	return PrimitiveDataType::EMPTY;
+}
+
+constexpr PrimitiveDataType classifyVectorType(char element, char hi, char lo, char lanes)
+{
+	// element: 'f' or 'i', hi/lo: the two digits of the element width, lanes: the lane count
+	if (element == 'f' && hi == '3' && lo == '2') return lanes == '4' ? PrimitiveDataType::f32x4 : lanes == '8' ? PrimitiveDataType::f32x8 : PrimitiveDataType::EMPTY;
+	if (element == 'f' && hi == '6' && lo == '4') return lanes == '2' ? PrimitiveDataType::f64x2 : lanes == '4' ? PrimitiveDataType::f64x4 : PrimitiveDataType::EMPTY;
+	if (element == 'i' && hi == '3' && lo == '2') return lanes == '4' ? PrimitiveDataType::i32x4 : lanes == '8' ? PrimitiveDataType::i32x8 : PrimitiveDataType::EMPTY;
+	if (element == 'i' && hi == '6' && lo == '4') return lanes == '2' ? PrimitiveDataType::i64x2 : lanes == '4' ? PrimitiveDataType::i64x4 : PrimitiveDataType::EMPTY;
+	return PrimitiveDataType::EMPTY;
+}
+
+// Maps a word (keyword, builtin type or identifier) to its token type in one step,
+// dataType is only set for builtin types
+constexpr WordClass classifyWord(std::string_view word)
+{
+	constexpr WordClass ident = { TokenType::IDENT, PrimitiveDataType::EMPTY };
+
+	switch (word.size())
+	{
+	case 2:
+		if (word[0] == 'f' && word[1] == 'n')
+			return { TokenType::FN, PrimitiveDataType::EMPTY };
+		if (word[0] == 'i' && word[1] == 'n')
+			return { TokenType::IN, PrimitiveDataType::EMPTY };
+		if (word[1] == '8')
+		{
+			if (word[0] == 'i') return { TokenType::BuiltinType, PrimitiveDataType::i8 };
+			if (word[0] == 'u') return { TokenType::BuiltinType, PrimitiveDataType::u8 };
+		}
+		return ident;
+	case 3:
+		switch (word[0])
+		{
+		case 'l':
+			if (word == "let")
+				return { TokenType::LET, PrimitiveDataType::EMPTY };
+			return ident;
+		case 'i':
+		case 'u':
+		{
+			PrimitiveDataType type = classifyIntWidth(word[0], word[1], word[2]);
+			if (type != PrimitiveDataType::EMPTY)
+				return { TokenType::BuiltinType, type };
+			return ident;
+		}
+		case 'f':
+			if (word[1] == '3' && word[2] == '2') return { TokenType::BuiltinType, PrimitiveDataType::f32 };
+			if (word[1] == '6' && word[2] == '4') return { TokenType::BuiltinType, PrimitiveDataType::f64 };
+			if (word[1] == 'o' && word[2] == 'r') return { TokenType::FOR, PrimitiveDataType::EMPTY };
+			return ident;
+		default:
+			return ident;
+		}
+	case 4:
+		if (word == "void") return { TokenType::BuiltinType, PrimitiveDataType::VOID };
+		if (word == "i128") return { TokenType::BuiltinType, PrimitiveDataType::i128 };
+		if (word == "u128") return { TokenType::BuiltinType, PrimitiveDataType::u128 };
+		return ident;
+	case 5:
+		if (word == "const") return { TokenType::CONST, PrimitiveDataType::EMPTY };
+		if (word[3] == 'x')
+		{
+			PrimitiveDataType type = classifyVectorType(word[0], word[1], word[2], word[4]);
+			if (type != PrimitiveDataType::EMPTY)
+				return { TokenType::BuiltinType, type };
+		}
+		return ident;
+	case 6:
+		if (word == "return") return { TokenType::RETURN, PrimitiveDataType::EMPTY };
+		if (word == "extern") return { TokenType::EXTERN, PrimitiveDataType::EMPTY };
+		return ident;
+	default:
+		return ident;
+	}
+}
+
+// Maps a symbol lexeme (1 to 3 chars) to its token type
+constexpr std::optional<TokenType> classifySymbol(std::string_view sym)
+{
+	if (sym.size() == 1)
+	{
+		switch (sym[0])
+		{
+		case '(': return TokenType::LParan;
+		case ')': return TokenType::RParan;
+		case '{': return TokenType::LCURLY;
+		case '}': return TokenType::RCURLY;
+		case '[': return TokenType::LSQUARE;
+		case ']': return TokenType::RSQUARE;
+		case ':': return TokenType::COLON;
+		case ';': return TokenType::SEMICOLON;
+		case '=': return TokenType::EQUALS;
+		case '+': return TokenType::PLUS;
+		case '-': return TokenType::MINUS;
+		case '*': return TokenType::STAR;
+		case '/': return TokenType::FORWARD_SLASH;
+		case '%': return TokenType::MODULUS;
+		case '<': return TokenType::LESS_THAN;
+		case '>': return TokenType::GREATER_THAN;
+		case ',': return TokenType::COMMA;
+		default: return {};
+		}
+	}
+	if (sym == "->") return TokenType::ARROW;
+	if (sym == "==") return TokenType::EQUALITY;
+	if (sym == "!=") return TokenType::NOT_EQUAL;
+	if (sym == "<=") return TokenType::LESS_EQUAL;
+	if (sym == ">=") return TokenType::GREATER_EQUAL;
+	if (sym == "...") return TokenType::ELLIPSIS;
+	if (sym == "..") return TokenType::DOT_DOT;
+	return {};
+}
+
+static_assert(classifyWord("fn").type == TokenType::FN);
+static_assert(classifyWord("i128").dataType == PrimitiveDataType::i128);
+static_assert(classifyWord("u16").dataType == PrimitiveDataType::u16);
+static_assert(classifyWord("f64").dataType == PrimitiveDataType::f64);
+static_assert(classifyWord("i31").type == TokenType::IDENT);
+static_assert(classifyWord("returns").type == TokenType::IDENT);
+static_assert(classifyWord("const").type == TokenType::CONST);
+static_assert(classifyWord("for").type == TokenType::FOR);
+static_assert(classifyWord("in").type == TokenType::IN);
+static_assert(classifyWord("fo").type == TokenType::IDENT);
+static_assert(classifyWord("f32x8").dataType == PrimitiveDataType::f32x8);
+static_assert(classifyWord("i64x2").dataType == PrimitiveDataType::i64x2);
+static_assert(classifyWord("f32x2").type == TokenType::IDENT);
+static_assert(*classifySymbol("...") == TokenType::ELLIPSIS);
+static_assert(*classifySymbol("<=") == TokenType::LESS_EQUAL);
+static_assert(*classifySymbol("..") == TokenType::DOT_DOT);
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Links object files into an executable by running the system compiler driver,
+// which knows where the C runtime and its startup files live.
+// An empty linker name picks cc (clang on Windows) from PATH.
+bool LinkExecutable(const std::vector<std::string>& objects, const std::string& outputPath, const std::string& linker);
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <string>
 #include <cstdarg>
+#include <mutex>
 
 // Define color escape sequences
 #define RESET_COLOR		"\033[0m"
@@ -16,6 +17,18 @@ enum LogLevel
 	Info = 0, Warning = 1, Error = 2, None = 3
 };
 
+// Collects log output instead of printing it, e.g. so veritasd can send it back to its client.
+// Several threads working for the same request may share one sink.
+class LogSink
+{
+public:
+	void		Append			(const std::string& text);
+	std::string	Take			();
+private:
+	std::mutex	m_mutex;
+	std::string	m_text;
+};
+
 class Logger
 {
 public:
@@ -25,11 +38,16 @@ public:
 	static	void		fmtLog			(const char* message, ...);
 	static	void		SetLogLevel		(LogLevel level);
 	static	LogLevel	GetLogLevel		();
+	/* Messages of the calling thread go to sink while it is set, nullptr prints to the console again */
+	static	void		SetThreadSink	(LogSink* sink);
+	static	LogSink*	GetThreadSink	();
 private:
 						Logger			();
 	static	void		LogInfo			(const std::string& message);
 	static	void		LogWarning		(const std::string& message);
 	static	void		LogError		(const std::string& message);
+	static	void		Write			(const std::string& text);
+	static	std::string	vformat			(const char* message, va_list args);
 private:
 	static LogLevel _level;
 };
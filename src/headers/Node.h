@@ -1,16 +1,16 @@
 #pragma once
+#include <algorithm>
 #include <optional>
 #include <vector>
-#include <memory>
+#include <string_view>
 #include <variant>
 
 #include "token.h"
+#include "Interner.h"
+#include "Arena.h"
 
-
-struct Ident
-{
-	std::string name;
-};
+// Every node lives in the Arena owned by its Program and is referenced by a plain pointer,
+// the whole tree is released in one go when the Program is destroyed.
 
 //struct Type
 //{
@@ -23,77 +23,157 @@ struct Ident
 struct Literal
 {
 	PrimitiveDataType type;
-	std::string value;
+	std::string_view value; // Points into the arena
 };
 
+// Integer literals are i32, one above INT32_MAX only fits an u32 and is unsigned
+inline bool isUnsignedLiteral(const Literal* literal)
+{
+	std::string_view digits = literal->value;
+	if (literal->type != PrimitiveDataType::i32 || digits.empty() || digits[0] == '-')
+		return false;
+	digits.remove_prefix(std::min(digits.find_first_not_of('0'), digits.size()));
+	return digits.size() > 10 || (digits.size() == 10 && digits > "2147483647");
+}
+
 struct Expr;
 struct ArgsList
 {
-	std::vector<std::unique_ptr<Expr>> list;
+	ArenaSpan<Expr*> list;
 };
 
 struct FnCall
 {
-	std::string name;
-	std::unique_ptr<ArgsList> args;
+	SymbolID name;
+	ArgsList* args = nullptr;
 };
 
 struct ReturnStmt
 {
-	std::unique_ptr<Expr> value;
+	Expr* value = nullptr; // nullptr for `return;` in a void fn
 };
 
 struct DeclStmt
 {
 	PrimitiveDataType type;
-	std::string IDENT;
-	std::unique_ptr<Expr> expr;
+	SymbolID IDENT;
+	Expr* expr = nullptr;
+	// `[type; arrayLength]`, 0 for a scalar. Arrays have no initializer and start out zeroed
+	uint32_t arrayLength = 0;
+	// `const`: expr is evaluated while compiling and the name stands for the resulting constant
+	bool isConst = false;
 };
 
-struct BinaryOp
+// ident = value; or ident[index] = value;
+struct AssignStmt
 {
-	TokenType type;
-	std::unique_ptr<Expr> LHS;
-	std::unique_ptr<Expr> RHS;
+	SymbolID ident;
+	Expr* index = nullptr;
+	Expr* value = nullptr;
 };
 
+enum class ExprKind : uint8_t
+{
+	Literal,
+	Ident,
+	Call,
+	Unary,
+	Binary,
+	Index,	// name[lhs], name is an array or slice
+};
+
+// One node of a flattened expression, operands are referred to by their index in the same array
+struct ExprNode
+{
+	// Every other field starts zeroed, a node is built by naming its kind and setting what that kind uses
+	explicit ExprNode(ExprKind _kind = ExprKind::Literal) : kind(_kind) {}
+
+	ExprKind kind;
+	TokenType op = TokenType::_EOF; // Operator of a Unary or Binary node, a Unary node only uses lhs
+	uint32_t lhs = 0;
+	uint32_t rhs = 0;
+	union
+	{
+		SymbolID name;
+		Literal* literal = nullptr;
+		FnCall* call;
+	};
+};
+
+// Nodes are stored in post-order: operands always come before the node using them
+// and the root is the last node
 struct Expr
 {
-	std::variant<std::unique_ptr<BinaryOp>, std::unique_ptr<Ident>, std::unique_ptr<Literal>, std::unique_ptr<FnCall>> value;
+	ArenaSpan<ExprNode> nodes;
+
+	const ExprNode& root() const { return nodes[nodes.size() - 1]; }
 };
 
 struct CompoundStmt;
+// for ident in start..end body: ident counts up from start while it is less than end, as an i64.
+// end is evaluated once before the first iteration and ident cannot be assigned in body
+struct ForStmt
+{
+	SymbolID ident;
+	Expr* start = nullptr;
+	Expr* end = nullptr;
+	CompoundStmt* body = nullptr;
+};
+
 struct Stmt
 {
-	std::variant<std::unique_ptr<DeclStmt>, std::unique_ptr<CompoundStmt>, std::unique_ptr<ReturnStmt>, std::unique_ptr<FnCall>> stmt;
+	std::variant<DeclStmt*, CompoundStmt*, ReturnStmt*, FnCall*, AssignStmt*, ForStmt*> stmt;
 };
 
 struct CompoundStmt
 {
-	std::vector<std::unique_ptr<Stmt>> statementList;
+	ArenaSpan<Stmt*> statementList;
 };
 
 struct ParamDecl
 {
-	std::string ident;
+	SymbolID ident = INVALID_SYMBOL;
 	PrimitiveDataType type;
 	bool VarArg = false;
+	// `[type]`: a slice, passed as a pointer to the first element and an i64 length
+	bool isSlice = false;
+	// Qualifiers of pointers and slices, written before the type: `dst: restrict align(32) [f32]`
+	// restrict: nothing else the function can reach refers to the same memory
+	bool isRestrict = false;
+	// align(N): the pointer is a multiple of N, 0 when not given
+	uint32_t alignment = 0;
+};
+
+// Written before `fn` as plain words, e.g. `inline pure fn`, they are not reserved elsewhere
+enum FnAttribute : uint8_t
+{
+	FN_INLINE = 1 << 0,		// always inlined
+	FN_NOINLINE = 1 << 1,
+	FN_PURE = 1 << 2,		// no side effects and always returns, reads memory at most
+	FN_COLD = 1 << 3,		// rarely called, optimized for size and kept off the hot path
+	FN_HOT = 1 << 4,
 };
 
 struct FnStmt
 {
-	std::string name;
+	SymbolID name;
 	PrimitiveDataType returnType;
 	
-	std::vector<std::unique_ptr<ParamDecl>> params; //-> For now no params
-	std::unique_ptr<CompoundStmt> compoundStmt;
+	ArenaSpan<ParamDecl*> params;
+	CompoundStmt* compoundStmt = nullptr;
 
 	bool isExtern = false;
+	// `const fn`: may also be called while evaluating a const, see ConstEvaluator
+	bool isConst = false;
+	// FnAttribute flags
+	uint8_t attributes = 0;
 };
 
 
 struct Program
 {
-	std::vector<std::unique_ptr<DeclStmt>> DeclStmts;
-	std::vector<std::unique_ptr<FnStmt>> FnStmts;
+	Arena arena;
+
+	std::vector<DeclStmt*> DeclStmts;
+	std::vector<FnStmt*> FnStmts;
 };
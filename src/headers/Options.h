@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ReportFormat : uint8_t
+{
+	None,
+	Text,
+	JSON,
+};
+
+enum class OptLevel : uint8_t
+{
+	O0,
+	O1,
+	O2,
+	O3,
+	Os,
+	Oz,
+};
+
+enum class EmitKind : uint8_t
+{
+	LLVM,		// Textual IR
+	Bitcode,
+	Assembly,
+	Object,
+	Executable,	// Object file handed to the system linker
+};
+
+// What `veritas bench` measures, see Bench.h
+enum class BenchKind : uint8_t
+{
+	Parse,			// Tokenizer and Parser throughput
+	Expressions,	// The same on expression heavy code
+	Keywords,		// classifyWord against the keyword and type maps it replaced
+};
+
+// Everything the command line can change about a compilation
+struct CompileOptions
+{
+	std::vector<std::string> inputPaths;
+	// `veritas run`: JIT compile the program and call its main instead of writing a file
+	bool run = false;
+	// Compile every function on its first call, startup then scales with the code that actually runs
+	bool lazyJIT = false;
+	// Arguments after `--`, passed to main when running
+	std::vector<std::string> programArgs;
+	// Empty means derived from the input file, see getOutputPath. With several inputs only allowed for an executable
+	std::string outputPath;
+	EmitKind emit = EmitKind::LLVM;
+	// Also dump the final module to stdout
+	bool printIR = false;
+
+	// Code generation target, empty strings mean the host defaults
+	std::string targetTriple;
+	std::string arch;
+	std::string cpu;		// "native" picks the host CPU and all of its features
+	std::string features;	// Comma separated, e.g. "+avx2,-avx512f"
+	std::string linker;
+	// Functions are split over this many modules generated, optimized and emitted in parallel, 0 is one per core
+	unsigned codegenShards = 1;
+	// Files compiled at the same time, 0 is one per core
+	unsigned jobs = 0;
+	// Outputs are reused from here when the source and options are unchanged, empty disables the cache
+	std::string cacheDir;
+	// llvm::parseCachePruningPolicy syntax, e.g. "cache_size_bytes=2g:prune_after=48h"
+	std::string cachePolicy;
+	bool cacheStats = false;
+	ReportFormat timeReport = ReportFormat::None;
+	OptLevel optLevel = OptLevel::O0;
+	// Bounds of evaluating a single const, see ConstEvalLimits
+	uint64_t constEvalSteps = 10'000'000;
+	uint64_t constEvalMemory = 64ull * 1024 * 1024;
+	// Runs the verifier after every optimization pass, slow but pinpoints a pass that breaks the IR
+	bool verifyEach = false;
+	bool showHelp = false;
+
+	// `veritas daemon` or a binary named veritasd: serve compile requests over a local socket
+	bool daemon = false;
+	// Send the build to a running veritasd, compiles in-process when none answers
+	bool useDaemon = false;
+	// `veritas bench <kind>`: time the front end instead of compiling
+	bool bench = false;
+	BenchKind benchKind = BenchKind::Parse;
+	// Functions of the generated program benchmarked when no input file is given
+	unsigned benchSize = 20000;
+	// The best of this many runs is reported
+	unsigned benchRuns = 5;
+
+	// Socket of veritasd, empty is the default location, see getDefaultSocketPath
+	std::string socketPath;
+	// Relative paths are resolved against this instead of the current directory when set, veritasd compiles for clients elsewhere
+	std::string workingDirectory;
+};
+
+// Returns false (after logging why) when the command line is invalid
+bool ParseCommandLine(int argc, char* argv[], CompileOptions& options);
+void PrintUsage();
+
+// Output file of compiling inputPath: -o if given, otherwise the input file with the extension of the emit kind
+std::string getOutputPath(const CompileOptions& options, const std::string& inputPath);
+// path made absolute against options.workingDirectory, unchanged when that is empty or path is already absolute
+std::string resolvePath(const CompileOptions& options, const std::string& path);
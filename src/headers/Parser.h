@@ -2,48 +2,73 @@
 #include <optional>
 #include <variant>
 #include <vector>
-#include <unordered_map>
-#include <stack>
 #include <memory>
 
 #include "token.h"
+#include "TokenStream.h"
 #include "Node.h"
 #include "Logger.h"
 
 class Parser
 {
 public:
-	Parser(std::vector<Token>& tokens);
+	Parser(TokenStream& tokens);
 
 	bool Parse();
 	bool ParseGlobalDecl();
-	std::unique_ptr<FnStmt> ParseFunction();
-	std::unique_ptr<ParamDecl> ParseParamDecl();
-	std::unique_ptr<CompoundStmt> ParseCompoundStmt();
-	std::unique_ptr<Stmt> ParseStmt();
-	std::unique_ptr<DeclStmt> ParseDeclStmt();
-	std::unique_ptr<ReturnStmt> ParseReturnStmt();
-	std::unique_ptr<Expr> ParseFunctionCallExpr();
-	std::unique_ptr<FnCall> ParseFunctionCallStmt();
-	std::unique_ptr<ArgsList> ParseArgsList();
-	bool ParseArg(std::unique_ptr<ArgsList>& argsList);
-	std::unique_ptr<Expr> ParseExpr();
-	std::unique_ptr<Expr> CreateVarExpr(const std::string& name);
-	std::unique_ptr<Expr> CreateLiteralExpr(const std::string& value, PrimitiveDataType dataType);
+	FnStmt* ParseFunction();
+	// Attribute words before `fn`, then checks they can be combined with each other and with the function
+	bool ParseFnAttributes(uint8_t& attributes);
+	bool CheckFnAttributes(const FnStmt* fnStmt);
+	ParamDecl* ParseParamDecl();
+	// `restrict` and `align(N)` in front of a parameter's type
+	bool ParseParamQualifiers(ParamDecl* param);
+	CompoundStmt* ParseCompoundStmt();
+	Stmt* ParseStmt();
+	DeclStmt* ParseDeclStmt();
+	// Type of a declaration, a builtin type or `[type; length]`
+	bool ParseDeclType(DeclStmt* declStmt);
+	ForStmt* ParseForStmt();
+	AssignStmt* ParseAssignStmt();
+	ReturnStmt* ParseReturnStmt();
+	bool ParseFunctionCallExpr(uint32_t& result);
+	FnCall* ParseFunctionCallStmt();
+	ArgsList* ParseArgsList();
+	Expr* ParseExpr();
+	// Pratt parser, result is the index of the subtree's root node in the current expression
+	bool ParseBinaryExpr(uint8_t minPrecedence, uint32_t& result);
+	bool ParseUnaryExpr(uint32_t& result);
+	uint32_t PushVarNode(SymbolID name);
+	uint32_t PushLiteralNode(std::string_view value, PrimitiveDataType dataType);
+	uint32_t PushCallNode(FnCall* fnCall);
 	std::unique_ptr<Program> getProgram();
+	size_t getNodeCount() const;
 private:
-	std::optional<Token> peek(int ahead = 0);
-	Token consume();
-	std::optional<Token> PeekAndCheck(TokenType type, int ahead = 0);
-	bool ApplyOperator();
+	// Lookahead never copies tokens, peek/PeekAndCheck return nullptr past the end
+	const Token* peek(int ahead = 0) const;
+	TokenType peekType(int ahead = 0) const;
+	const Token& consume();
+	const Token* PeekAndCheck(TokenType type, int ahead = 0) const;
+	// Consumes the next token only if it is of the given type
+	bool match(TokenType type);
+	size_t getLine(int ahead = 0) const;
+	uint32_t PushNode(const ExprNode& node);
 	PrimitiveDataType ptrTypeof(PrimitiveDataType type);
 
-	std::vector<Token> m_tokens;
+	TokenStream m_tokens;
 	size_t m_index = 0;
 	std::unique_ptr<Program> m_programAST;
-	
-	std::unordered_map<TokenType, std::pair<int, char>> OperandTuple;
-	
-	std::stack<std::unique_ptr<Expr>> m_nodeStack;
-	std::stack<Token> m_operatorStack;
+	// Nodes are allocated from the program's arena
+	Arena* m_arena;
+
+	// Nodes of the expressions being parsed, the innermost one starts at m_exprBase
+	std::vector<ExprNode> m_exprNodes;
+	size_t m_exprBase = 0;
+	size_t m_exprDepth = 0;
+	size_t m_exprNodeCount = 0;
+
+	// Child lists are collected here while parsing and then copied into the arena
+	std::vector<Stmt*> m_stmtScratch;
+	std::vector<Expr*> m_exprScratch;
+	std::vector<ParamDecl*> m_paramScratch;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Instructions.h>
+
+// Puts local variables in SSA form while their function is generated, so they never need an alloca.
+// After Braun et al., "Simple and Efficient Construction of Static Single Assignment Form" (CC 2013):
+// the current value of a variable is tracked per block, reading it in a block that did not assign it
+// looks through the predecessors and places a phi where several definitions meet. Trivial phis are
+// removed as soon as they are complete.
+class SSABuilder
+{
+public:
+	using Variable = uint32_t;
+
+	// Forgets the variables and blocks of the previous function
+	void Reset();
+
+	Variable NewVariable(llvm::Type* type, llvm::StringRef name);
+	void WriteVariable(Variable var, llvm::BasicBlock* block, llvm::Value* value);
+	llvm::Value* ReadVariable(Variable var, llvm::BasicBlock* block);
+
+	// Declares that every predecessor of block is known (all branches to it have been created).
+	// Reads in a block before it is sealed get a phi whose operands are filled in here
+	void SealBlock(llvm::BasicBlock* block);
+
+private:
+	llvm::Value* ReadVariableRecursive(Variable var, llvm::BasicBlock* block);
+	llvm::Value* AddPhiOperands(Variable var, llvm::PHINode* phi);
+	// Replaces a phi that merges a single value (besides itself) by that value, returns what is left
+	llvm::Value* TryRemoveTrivialPhi(llvm::PHINode* phi);
+	llvm::PHINode* CreatePhi(Variable var, llvm::BasicBlock* block);
+
+	struct VariableInfo
+	{
+		llvm::Type* type;
+		llvm::StringRef name;
+		// Value of the variable at the end of each block that defines it
+		llvm::DenseMap<llvm::BasicBlock*, llvm::Value*> currentDef;
+	};
+
+	std::vector<VariableInfo> m_variables;
+	llvm::SmallPtrSet<llvm::BasicBlock*, 16> m_sealedBlocks;
+	llvm::DenseMap<llvm::BasicBlock*, llvm::SmallVector<std::pair<Variable, llvm::PHINode*>, 4>> m_incompletePhis;
+	// Variable of every phi placed here, a removed phi has to be replaced in that variable's definitions
+	llvm::DenseMap<llvm::PHINode*, Variable> m_phiVariables;
+};
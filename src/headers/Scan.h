@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Character classes used by the tokenizer, ASCII only (std::isalpha & co. are locale aware)
+enum CharClass : uint8_t
+{
+	CHAR_ALPHA = 1 << 0,
+	CHAR_DIGIT = 1 << 1,
+	CHAR_SPACE = 1 << 2,
+};
+
+constexpr std::array<uint8_t, 256> makeCharClassTable()
+{
+	std::array<uint8_t, 256> table = {};
+	for (int c = 'a'; c <= 'z'; c++) table[c] |= CHAR_ALPHA;
+	for (int c = 'A'; c <= 'Z'; c++) table[c] |= CHAR_ALPHA;
+	for (int c = '0'; c <= '9'; c++) table[c] |= CHAR_DIGIT;
+	for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) table[(uint8_t)c] |= CHAR_SPACE;
+	return table;
+}
+
+inline constexpr std::array<uint8_t, 256> g_charClass = makeCharClassTable();
+
+inline bool isAlphaChar(char c) { return g_charClass[(uint8_t)c] & CHAR_ALPHA; }
+inline bool isDigitChar(char c) { return g_charClass[(uint8_t)c] & CHAR_DIGIT; }
+inline bool isAlnumChar(char c) { return g_charClass[(uint8_t)c] & (CHAR_ALPHA | CHAR_DIGIT); }
+inline bool isSpaceChar(char c) { return g_charClass[(uint8_t)c] & CHAR_SPACE; }
+
+// Run scanners used by the tokenizer, every function looks at [p, end) and returns a
+// pointer to the first byte that stops the run (or end). The ones taking `newlines`
+// add the number of '\n' they stepped over to it.
+// An SSE2 or AVX2 implementation is picked at runtime when the cpu supports it,
+// otherwise the scalar one is used.
+struct ScanFunctions
+{
+	// Stops at the first non whitespace byte
+	const char* (*skipWhitespace)(const char* p, const char* end, size_t& newlines);
+	// Stops at the first byte that is not [A-Za-z0-9]
+	const char* (*skipAlnum)(const char* p, const char* end);
+	// Stops at the first byte that is not [0-9]
+	const char* (*skipDigits)(const char* p, const char* end);
+	// Stops at the next '\n'
+	const char* (*findLineEnd)(const char* p, const char* end);
+	// Stops at the '*' of the next "*/"
+	const char* (*findBlockCommentEnd)(const char* p, const char* end, size_t& newlines);
+	// Stops at the next '"' or '\\'
+	const char* (*findStringSpecial)(const char* p, const char* end, size_t& newlines);
+
+	const char* name;
+};
+
+const ScanFunctions& getScanFunctions();
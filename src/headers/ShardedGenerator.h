@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <llvm/Support/ThreadPool.h>
+
+#include "Generate.h"
+
+// Splits the functions of a program over shards, each one a Generator with its own
+// LLVMContext and Module, so that generation, optimization and machine code emission
+// run on several cores. Functions of other shards are only declared in a shard, the
+// object files link against each other or MergeShards joins the modules again.
+// With a single shard this is exactly one Generator and no threads are started.
+class ShardedGenerator
+{
+public:
+	ShardedGenerator(const Program& program, StringInterner& interner, const std::string& moduleName, const std::string& outPath, unsigned shardCount);
+
+	bool InitTarget(const CompileOptions& options);
+
+	void SetConstEvalLimits(const ConstEvalLimits& limits);
+
+	// Deals the functions out by size and generates all shards in parallel
+	bool Generate();
+
+	bool VerifyModules();
+
+	void OptimizeModules(OptLevel level, bool verifyEach);
+
+	// Emits one object file per shard, named after basePath, and appends their paths to objects
+	bool EmitObjects(const std::string& basePath, std::vector<std::string>& objects);
+
+	// Links every shard into the first one, which then holds the whole program with the
+	// linkage and function order an unsharded compilation would have produced
+	bool MergeShards();
+
+	// The generator holding the whole program, only valid after MergeShards
+	Generator& getMerged();
+
+	// Hands every shard's module over, e.g. to the JIT, the shards are unusable afterwards
+	std::vector<llvm::orc::ThreadSafeModule> takeModules();
+
+	void PrintModules(llvm::raw_ostream& out) const;
+
+	const llvm::TargetMachine* getTargetMachine() const;
+	size_t getInstructionCount() const;
+	size_t getShardCount() const;
+
+private:
+	void Partition();
+
+	// Runs work(shardIndex) for every shard on the pool, true if every call returned true
+	template <typename Work>
+	bool RunOnShards(Work work);
+
+private:
+	const Program& m_program;
+	std::vector<std::unique_ptr<Generator>> m_shards;
+	std::unique_ptr<llvm::ThreadPool> m_pool;
+};
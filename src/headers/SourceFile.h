@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Read-only view over a source file.
+// The file is memory-mapped when possible so the tokenizer (and the tokens it
+// produces) can point straight into the OS pages instead of a private copy.
+// The SourceFile must outlive every Token that was created from its buffer.
+class SourceFile
+{
+public:
+	SourceFile() = default;
+	~SourceFile();
+
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	std::string_view getBuffer() const;
+	const std::string& getPath() const;
+	bool isMapped() const;
+
+private:
+	bool ReadFallback();
+
+	std::string m_path;
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_mapped = false;
+
+	// Only used when the file could not be mapped (pipes, empty files ...)
+	std::string m_fallbackBuffer;
+
+#ifdef _WIN32
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Interner.h"
+
+namespace llvm
+{
+	class Constant;
+	class Type;
+	class Value;
+}
+
+struct varInfo
+{
+	// Address of a global or of an array, nullptr for a local scalar, whose value is tracked by the SSABuilder
+	// instead. For a slice the pointer to its first element
+	llvm::Value* vAddr = nullptr;
+	// An llvm::ArrayType for arrays, the element type for slices
+	llvm::Type* vType = nullptr;
+	uint32_t ssaVariable = 0;
+	// Value of a `const`, which has neither an address nor an SSA variable
+	llvm::Constant* constant = nullptr;
+	// i64 number of elements of a slice, nullptr for everything else
+	llvm::Value* length = nullptr;
+	// The counter of a for loop cannot be assigned
+	bool isLoopVariable = false;
+	// Declared as an unsigned integer, or an array or slice of them. LLVM types carry no signedness
+	bool isUnsigned = false;
+};
+
+// Variables visible at the current point of code generation. There is one slot per SymbolID, so a
+// lookup is an index instead of a hash. Declaring over a visible variable saves the old slot in an
+// undo log which PopScope replays, entering and leaving a scope only costs what was declared in it.
+class SymbolTable
+{
+public:
+	// Returns false if id is already declared in the innermost scope
+	bool Declare(SymbolID id, const varInfo& info);
+	// Innermost declaration of id, nullptr if there is none
+	const varInfo* Lookup(SymbolID id) const;
+	bool isDeclaredInScope(SymbolID id) const;
+
+	void PushScope();
+	// Everything declared since the matching PushScope goes out of scope, shadowed variables are visible again
+	void PopScope();
+	// Sizes the slots for every symbol interned so far, Declare grows them for later ones
+	void Reserve(size_t symbolCount);
+
+private:
+	struct Slot
+	{
+		varInfo info;
+		// Scope that declared info, 0 when nothing is declared. The global scope is 1
+		uint32_t depth = 0;
+	};
+	struct UndoEntry
+	{
+		SymbolID id;
+		Slot previous;
+	};
+
+	uint32_t getDepth() const;
+
+	std::vector<Slot> m_slots;
+	std::vector<UndoEntry> m_undoLog;
+	// Size of the undo log when each open scope was entered
+	std::vector<size_t> m_scopeStarts;
+};
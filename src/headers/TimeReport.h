@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct PhaseStats
+{
+	std::string name;
+	double wallMs = 0.0;
+	double cpuMs = 0.0;
+	// High-water mark of the process at the end of the phase, so it never decreases
+	uint64_t peakRssKB = 0;
+	uint64_t allocations = 0;
+};
+
+// Collects per phase timings of one compilation for --time-report.
+// Phases are measured back to back: BeginPhase, the work, EndPhase.
+class TimeReport
+{
+public:
+	// A per thread report only counts the CPU time and allocations of the thread running its phases,
+	// which keeps compilations running side by side from being charged for each other
+	explicit TimeReport(bool perThread = false);
+
+	// Allocations are only counted while one of these is enabled, so a compilation without --time-report
+	// does not pay for counting them. Phases outside of it report no allocations
+	class AllocationCounting
+	{
+	public:
+		explicit AllocationCounting(bool enabled);
+		~AllocationCounting();
+
+		AllocationCounting(const AllocationCounting&) = delete;
+		AllocationCounting& operator=(const AllocationCounting&) = delete;
+
+	private:
+		bool m_enabled;
+	};
+
+	void BeginPhase(const char* name);
+	void EndPhase();
+
+	// Named totals such as tokens or IR instructions, printed after the phases
+	void SetCount(const char* name, uint64_t value);
+
+	const std::vector<PhaseStats>& getPhases() const;
+
+	// Adds the phases and counts of other to the ones of the same name, used to total several files
+	void Merge(const TimeReport& other);
+
+	void PrintText(std::ostream& out, const char* title = "Veritas time report") const;
+	void PrintJSON(std::ostream& out) const;
+
+	// Report of a multi-file build: one line per file, the phases summed over all files and the build's own phases
+	static void PrintBuildText(std::ostream& out, const std::vector<std::string>& files, const std::vector<TimeReport>& reports, const TimeReport& build);
+	static void PrintBuildJSON(std::ostream& out, const std::vector<std::string>& files, const std::vector<TimeReport>& reports, const TimeReport& build);
+
+	// Process wide counters, usable without a report. Allocations are counted as described at AllocationCounting
+	static double getWallTimeMs();
+	static double getCPUTimeMs();
+	static uint64_t getPeakRssKB();
+	static uint64_t getAllocationCount();
+	// Same counters for the calling thread only
+	static double getThreadCPUTimeMs();
+	static uint64_t getThreadAllocationCount();
+
+private:
+	void WriteJSON(std::ostream& out) const;
+	// The process or thread counter, depending on the kind of report
+	double readCPUTimeMs() const;
+	uint64_t readAllocationCount() const;
+
+	std::vector<PhaseStats> m_phases;
+	std::vector<std::pair<std::string, uint64_t>> m_counts;
+
+	double m_phaseWallStart = 0.0;
+	double m_phaseCPUStart = 0.0;
+	uint64_t m_phaseAllocStart = 0;
+	bool m_perThread = false;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "token.h"
+
+// Owns the token array of a source file plus the data that is only needed off the hot path:
+// the text of escaped string literals and the newline table used for diagnostics.
+// Token text is sliced out of the source buffer, so that buffer must outlive the stream.
+class TokenStream
+{
+public:
+	TokenStream() = default;
+	explicit TokenStream(std::string_view source);
+
+	TokenStream(TokenStream&&) = default;
+	TokenStream& operator=(TokenStream&&) = default;
+
+	std::vector<Token>& getTokens();
+	const std::vector<Token>& getTokens() const;
+	size_t size() const;
+	const Token& operator[](size_t index) const;
+
+	std::string_view getSource() const;
+
+	// Text of the token, escaped string literals come from the side table
+	std::string_view getText(const Token& token) const;
+	// Stores the unescaped contents of a string literal, returns the payload to put in its token
+	uint32_t AddEscapedLiteral(std::string&& literal);
+
+	// 1 based line and column, computed on demand
+	size_t getLine(const Token& token) const;
+	size_t getColumn(const Token& token) const;
+	size_t getLineOfOffset(size_t offset) const;
+
+private:
+	void BuildLineTable() const;
+
+	std::string_view m_source;
+	std::vector<Token> m_tokens;
+	std::deque<std::string> m_escapedLiterals;
+
+	// Offset of the first character of every line, built the first time a line is asked for
+	mutable std::vector<uint32_t> m_lineStarts;
+};
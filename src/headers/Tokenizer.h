@@ -1,34 +1,35 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 
 #include "token.h"
+#include "TokenStream.h"
+#include "Interner.h"
+#include "Scan.h"
 #include "Logger.h"
 
 class Tokenizer
 {
 public:
-	Tokenizer(const std::string& program);
+	// The program buffer is not copied, it must outlive the tokenizer and its tokens
+	// Identifiers are interned into the given table
+	Tokenizer(std::string_view program, StringInterner& interner);
 	bool Tokenize();
-	std::vector<Token>& getTokens();
+	TokenStream& getTokens();
 
 private:
-	std::string readWord();
-	std::optional<char> peek(size_t ahead = 0);
-	char consume();
+	std::string_view readWord();
+	void AddToken(TokenType type, const char* start, size_t length, PrimitiveDataType dataType = PrimitiveDataType::EMPTY, uint32_t payload = 0);
 
-	bool isDataType(const std::string& key);
-	std::optional<TokenType> keywordExist(const std::string& key);
 	bool isSymbol(char c);
 
 	size_t m_index;
 	size_t m_currentLine;
 	
-	std::string m_program;
-	std::vector<Token> m_tokens;
-	std::unordered_map<std::string, TokenType> m_keywordMap;
-	std::unordered_map<std::string, PrimitiveDataType> m_builtinTypeMap;
-	std::unordered_map<std::string, TokenType> m_symbolMap;
+	std::string_view m_program;
+	StringInterner& m_interner;
+	const ScanFunctions& m_scan;
+	TokenStream m_stream;
 };
 
@@ -1,14 +1,19 @@
 #pragma once
-#include <string>
+#include <cstdint>
 #include <optional>
 
-enum TokenType
+#include "Interner.h"
+
+enum TokenType : uint8_t
 {
     //keywords
     RETURN,
     LET,
     FN,
     EXTERN,
+    CONST,
+    FOR,
+    IN,
 
     // type keyword
     BuiltinType,
@@ -24,17 +29,25 @@ enum TokenType
     RParan,
     LCURLY,
     RCURLY,
+    LSQUARE,
+    RSQUARE,
     SEMICOLON,
     COLON,
     ARROW,
     EQUALS,
     EQUALITY,
+    NOT_EQUAL,
+    LESS_THAN,
+    LESS_EQUAL,
+    GREATER_THAN,
+    GREATER_EQUAL,
     PLUS,
     MINUS,
     FORWARD_SLASH,
     STAR,
     MODULUS,
     ELLIPSIS,
+    DOT_DOT,
     COMMA,
 
     //MISC.
@@ -42,7 +55,7 @@ enum TokenType
     _EOF
 };
 
-enum PrimitiveDataType
+enum PrimitiveDataType : uint8_t
 {
     EMPTY,
     VOID,
@@ -82,20 +95,46 @@ enum PrimitiveDataType
     u128,
     i128,
 
-    str
+    // SIMD vectors of 128 and 256 bits, named element type 'x' lane count
+    f32x4,
+    f32x8,
+    f64x2,
+    f64x4,
+    i32x4,
+    i32x8,
+    i64x2,
+    i64x4,
+
+    str,
+
+    // Result of a comparison, has no keyword. Only constant folding creates literals of it
+    i1
 };
 
+// Integers of these types widen with zext and convert to floats as unsigned, all others as signed
+inline bool isUnsignedType(PrimitiveDataType type)
+{
+	return (type >= PrimitiveDataType::u8 && type <= PrimitiveDataType::u64) || type == PrimitiveDataType::u128;
+}
+
+// Tokens are kept to 16 bytes so a whole file's stream stays dense in cache,
+// the text and line of a token are recovered through the TokenStream that owns it.
 struct Token
 {
+	uint32_t offset; /*Byte offset of the lexeme in the source buffer*/
+	uint32_t length;
 	TokenType type;
-	std::string value;
-    PrimitiveDataType dataType; /*Only used when token is a BuiltIn dataType*/
-    size_t lineNum;
-
-    Token(TokenType _type, std::string& _val, size_t line, PrimitiveDataType dt = PrimitiveDataType::EMPTY)
-        : type(_type), lineNum(line), dataType(dt)
-    {
-        if (_val != "")
-            value = std::move(_val);
-    }
-};
\ No newline at end of file
+	PrimitiveDataType dataType; /*Only used when token is a BuiltIn dataType*/
+	union
+	{
+		SymbolID symbol; /*Only used when token is an IDENT*/
+		uint32_t literalIndex; /*STRING_LITERAL: 1 based index of its escaped text, 0 if it can be read from the source*/
+	};
+
+	Token(TokenType _type, uint32_t _offset, uint32_t _length, PrimitiveDataType dt = PrimitiveDataType::EMPTY, uint32_t payload = 0)
+		: offset(_offset), length(_length), type(_type), dataType(dt), symbol(payload)
+	{
+	}
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
\ No newline at end of file
@@ -1,13 +1,10 @@
 #include <iostream>
-#include <fstream>
-#include <ostream>
-#include <sstream>
-#include <filesystem>
 
-#include "headers/llvm_includes.h"
-#include "headers/Tokenizer.h"
-#include "headers/Generate.h"
+#include "headers/Bench.h"
+#include "headers/Daemon.h"
+#include "headers/Driver.h"
 #include "headers/Logger.h"
+#include "headers/Options.h"
 
 // #define TEST_LLVM 0
 
@@ -16,46 +13,46 @@ int main(int argc, char* argv[])
 #ifndef TEST_LLVM
 	Logger::SetLogLevel(LogLevel::Info);
 
-	std::string path;
-#ifndef _DEBUG
-	// IF *not* in debug mode
-	if (argc < 2)
+	CompileOptions options;
+	if (!ParseCommandLine(argc, argv, options))
 	{
-		Logger::Log(LogLevel::Error, "No input file given");
+		PrintUsage();
 		return -1;
 	}
-#else // IF in debug mode
-	Logger::Log("Enter a file path: ");
-	std::cin >> path;
-#endif // !_DEBUG
-
-	std::string program;
+	if (options.showHelp)
 	{
-		std::ifstream in(path);
-		if (!in.is_open())
-		{
-			Logger::fmtLog(LogLevel::Error, "Failed to open file: %s", path.data());
-			return -1;
-		}
-
-		std::ostringstream sstr;
-		sstr << in.rdbuf();
-		program = sstr.str();
+		PrintUsage();
+		return 0;
 	}
+	if (options.daemon)
+		return RunDaemon(options);
+	if (options.bench)
+		return RunBenchmark(options);
 
-	Tokenizer tokenizer(program);
-	if (!tokenizer.Tokenize())
+#ifdef _DEBUG
+	// IF in debug mode the file may also be typed in
+	if (options.inputPaths.empty())
+	{
+		Logger::Log("Enter a file path: ");
+		std::string path;
+		std::cin >> path;
+		options.inputPaths.push_back(path);
+	}
+#endif // _DEBUG
+	if (options.inputPaths.empty())
+	{
+		Logger::Log(LogLevel::Error, "No input file given");
 		return -1;
-	std::vector<Token> tokens(std::move(tokenizer.getTokens()));
+	}
 
-	Parser parser(tokens);
-	if (!parser.Parse())
-		return -1;
-	
-	std::string outFile = "./tempVeritas/out.ll";
-	Generator llvmGEN(parser.getProgram(), path, outFile);
-	
-	llvmGEN.Generate();
+	// The daemon only builds files, running a program and --print-ir stay in this process
+	int exitCode = 0;
+	if (options.useDaemon && !options.run && !options.printIR && CompileWithDaemon(options, argc, argv, exitCode))
+		return exitCode;
+
+	if (options.run)
+		return RunFile(options, std::cerr);
+	return BuildFiles(options, std::cerr);
 #else
 	std::string str = "out.ll";
 	Generator gen(str);